@@ -0,0 +1,167 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// acquisitionbench.cpp
+// end-to-end acquisition benchmark against the simulator
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "acquisitionbench.h"
+#include "benchreport.h"
+#include "allocationcounter.h"
+#include "dp700.h"
+#include "pollscheduler.h"
+#include "sim/dp700sim.h"
+#include <QThread>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <time.h>
+
+// the poll is started after the link settled
+#define WARMUP_MS       500
+#define OPEN_TIMEOUT_MS 2000
+
+// alternating setpoints, both below the current limit of the simulated load
+static const double setVoltages[2] = { 5.0, 6.0 };
+static const double setCurrent = 1.0;
+
+static qint64 threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static double percentile(QVector<qint64> &values, double p)
+{
+    if (values.isEmpty())
+        return 0;
+    int i = qMin(values.size()-1, int(std::ceil(p * values.size())) - 1);
+    std::nth_element(values.begin(), values.begin() + qMax(0, i), values.end());
+    return values.at(qMax(0, i)) / 1e6;
+}
+
+static bool runOne(const AcquisitionBench::CONFIG &cfg, quint32 baudrate, bool batched)
+{
+    // the simulator runs in its own thread, the device in this one, so
+    // CPU time and allocations of this thread belong to the device alone
+    QThread simThread;
+    simThread.setObjectName("DP700 simulator");
+    DP700Sim::CONFIG simCfg = DP700Sim::defaultConfig();
+    simCfg.baudrate = baudrate;
+    simCfg.latencyMs = cfg.latencyMs;
+    simCfg.jitterMs = cfg.jitterMs;
+    DP700Sim *sim = new DP700Sim(simCfg);
+    sim->moveToThread(&simThread);
+    simThread.start();
+    bool simOk = false;
+    QMetaObject::invokeMethod(sim, [sim, &simOk]() { simOk = sim->open(); }, Qt::BlockingQueuedConnection);
+
+    bool ok = false;
+    if (simOk) {
+        DP700 dev(sim->portName(), baudrate);
+        PollScheduler scheduler(&dev);
+        dev.setBatchedPoll(batched);
+
+        QEventLoop loop;
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+        bool opened = false;
+        QObject::connect(&dev, &SerDev::opened, &loop, [&](bool success) { opened = success; loop.quit(); });
+        timeout.start(OPEN_TIMEOUT_MS);
+        dev.open();
+        if (!opened)
+            loop.exec();
+
+        if (opened) {
+            quint64 cycles = 0;
+            bool measuring = false;
+            QVector<qint64> ackNs;
+            int setIndex = 0;
+            qint64 setSentNs = -1;
+            QElapsedTimer clock;
+            clock.start();
+            QObject::connect(&dev, &DP700::pollComplete, &loop, [&]() { if (measuring) ++cycles; });
+            QObject::connect(&dev, &DP700::voltageSet, &loop, [&](int channel, double v) {
+                Q_UNUSED(channel)
+                // acknowledged once the readback shows the new setpoint
+                if ((setSentNs >= 0) && (qAbs(v - setVoltages[setIndex]) < 0.005)) {
+                    if (measuring)
+                        ackNs.append(clock.nsecsElapsed() - setSentNs);
+                    setSentNs = -1;
+                }
+            });
+            QTimer setTimer;
+            QObject::connect(&setTimer, &QTimer::timeout, &loop, [&]() {
+                if (setSentNs >= 0)
+                    return;
+                setIndex ^= 1;
+                setSentNs = clock.nsecsElapsed();
+                dev.setVoltageCurrent(setVoltages[setIndex], setCurrent);
+            });
+            dev.setOnOff(true);
+            scheduler.start();
+            if (cfg.setpointMs > 0)
+                setTimer.start(cfg.setpointMs);
+            timeout.start(WARMUP_MS);
+            loop.exec();
+
+            measuring = true;
+            qint64 cpu0 = threadCpuNs();
+            quint64 alloc0 = AllocationCounter::threadCount();
+            qint64 t0 = clock.nsecsElapsed();
+            timeout.start(int(cfg.seconds * 1000));
+            loop.exec();
+            measuring = false;
+            qint64 elapsed = clock.nsecsElapsed() - t0;
+            qint64 cpu = threadCpuNs() - cpu0;
+            quint64 allocs = AllocationCounter::threadCount() - alloc0;
+            scheduler.stop();
+            setTimer.stop();
+
+            QJsonObject o;
+            o["bench"] = "acquisition";
+            o["baudrate"] = qint64(baudrate);
+            o["poll"] = batched ? "batched" : "chained";
+            o["sim_latency_ms"] = cfg.latencyMs;
+            o["seconds"] = elapsed / 1e9;
+            o["cycles"] = qint64(cycles);
+            o["cycles_per_second"] = cycles * 1e9 / elapsed;
+            o["setpoint_acks"] = ackNs.size();
+            o["setpoint_ack_p50_ms"] = percentile(ackNs, 0.50);
+            o["setpoint_ack_p99_ms"] = percentile(ackNs, 0.99);
+            o["cpu_us_per_sample"] = cycles ? cpu / 1e3 / cycles : 0.0;
+            o["allocs_per_sample"] = cycles ? double(allocs) / cycles : 0.0;
+            o["alloc_counting"] = AllocationCounter::method();
+            BenchReport::print(o);
+            ok = cycles > 0;
+        } else {
+            qCritical() << "cannot open" << sim->portName();
+        }
+    }
+
+    QMetaObject::invokeMethod(sim, [sim]() { delete sim; }, Qt::BlockingQueuedConnection);
+    simThread.quit();
+    simThread.wait();
+    return ok;
+}
+
+bool AcquisitionBench::run(const CONFIG &cfg)
+{
+    bool ok = true;
+    for (quint32 baudrate : cfg.baudrates) {
+        ok &= runOne(cfg, baudrate, false);
+        ok &= runOne(cfg, baudrate, true);
+    }
+    return ok;
+}
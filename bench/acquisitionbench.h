@@ -0,0 +1,34 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// acquisitionbench.h
+// end-to-end acquisition benchmark against the simulator, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef ACQUISITIONBENCH_H
+#define ACQUISITIONBENCH_H
+
+#include <QList>
+
+namespace AcquisitionBench
+{
+    typedef struct {
+        QList<quint32>  baudrates;
+        double          seconds;        // measuring time per run
+        double          latencyMs;      // simulated instrument latency
+        double          jitterMs;
+        int             setpointMs;     // period of setpoint changes
+    } CONFIG;
+
+    // polls the DP700 + SerDev stack as fast as possible against a simulated
+    // instrument on a pseudo terminal, chained and batched at every baud rate,
+    // returns false if a run did not complete any cycle
+    bool run(const CONFIG &cfg);
+}
+
+#endif // ACQUISITIONBENCH_H
@@ -0,0 +1,99 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// allocationcounter.cpp
+// counts heap allocations of the benchmark process
+// on glibc malloc itself is wrapped, which also covers Qt's containers,
+// elsewhere only operator new can be replaced portably
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "allocationcounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<quint64> allocations(0);
+// static TLS of the executable, accessing it never allocates
+static thread_local quint64 threadAllocations = 0;
+
+quint64 AllocationCounter::count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+quint64 AllocationCounter::threadCount()
+{
+    return threadAllocations;
+}
+
+#if defined(__GLIBC__)
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    ++threadAllocations;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    ++threadAllocations;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    ++threadAllocations;
+    return __libc_realloc(ptr, size);
+}
+}
+
+const char *AllocationCounter::method()
+{
+    return "malloc";
+}
+
+#else
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    ++threadAllocations;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+const char *AllocationCounter::method()
+{
+    return "new";
+}
+
+#endif
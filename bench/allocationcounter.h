@@ -0,0 +1,28 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// allocationcounter.h
+// counts heap allocations of the benchmark process, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+namespace AllocationCounter
+{
+    // number of heap allocations since program start, all threads
+    quint64 count();
+    // number of heap allocations of the calling thread
+    quint64 threadCount();
+    // "malloc" if every allocation is seen (glibc), "new" if only operator new is
+    const char *method();
+}
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,42 @@
+QT -= gui
+QT += serialport
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = dp700bench
+
+# the benchmarks use the application sources directly
+INCLUDEPATH += ..
+
+# the acquisition benchmark talks to the simulator on a pseudo terminal
+!linux: error("the acquisition benchmark needs Linux pseudo terminals")
+
+SOURCES += \
+    main.cpp \
+    allocationcounter.cpp \
+    benchreport.cpp \
+    parserbench.cpp \
+    ../scpireply.cpp \
+    acquisitionbench.cpp \
+    ../serdev.cpp \
+    ../dp700.cpp \
+    ../instrumentprofile.cpp \
+    ../linkstats.cpp \
+    ../pollscheduler.cpp \
+    ../sim/dp700sim.cpp
+
+HEADERS += \
+    allocationcounter.h \
+    benchreport.h \
+    parserbench.h \
+    ../byteview.h \
+    ../scpireply.h \
+    acquisitionbench.h \
+    ../serdev.h \
+    ../dp700.h \
+    ../instrumentprofile.h \
+    ../linkstats.h \
+    ../pollscheduler.h \
+    ../sample.h \
+    ../sim/dp700sim.h
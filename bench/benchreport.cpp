@@ -0,0 +1,22 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// benchreport.cpp
+// machine readable benchmark output
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "benchreport.h"
+#include <QJsonDocument>
+#include <cstdio>
+
+void BenchReport::print(const QJsonObject &result)
+{
+    QByteArray line = QJsonDocument(result).toJson(QJsonDocument::Compact);
+    fprintf(stdout, "%s\n", line.constData());
+    fflush(stdout);
+}
@@ -0,0 +1,24 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// benchreport.h
+// machine readable benchmark output, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <QJsonObject>
+
+namespace BenchReport
+{
+    // one compact JSON object per line on stdout
+    void print(const QJsonObject &result);
+}
+
+#endif // BENCHREPORT_H
@@ -0,0 +1,49 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// main.cpp
+// benchmark entry point
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "parserbench.h"
+#include "acquisitionbench.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("dp700bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("DP700 benchmarks, one JSON object per result line on stdout");
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption("iterations", "parser benchmark iterations", "n", "1000000");
+    QCommandLineOption baudOption("baud", "comma separated baud rates of the acquisition benchmark", "rates", "9600,38400,115200");
+    QCommandLineOption secondsOption("seconds", "acquisition time per run, 0: skip the acquisition benchmark", "s", "5");
+    QCommandLineOption latencyOption("latency", "simulated instrument latency", "ms", "2");
+    QCommandLineOption jitterOption("jitter", "simulated instrument latency jitter", "ms", "0");
+    QCommandLineOption setpointOption("setpoint", "period of setpoint changes, 0: none", "ms", "100");
+    parser.addOptions(QList<QCommandLineOption>() << iterationsOption << baudOption << secondsOption
+                      << latencyOption << jitterOption << setpointOption);
+    parser.process(a);
+
+    bool ok = ParserBench::check();
+    ok &= ParserBench::run(parser.value(iterationsOption).toInt());
+
+    AcquisitionBench::CONFIG cfg;
+    for (const QString &rate : parser.value(baudOption).split(',', Qt::SkipEmptyParts))
+        cfg.baudrates.append(rate.toUInt());
+    cfg.seconds = parser.value(secondsOption).toDouble();
+    cfg.latencyMs = parser.value(latencyOption).toDouble();
+    cfg.jitterMs = parser.value(jitterOption).toDouble();
+    cfg.setpointMs = parser.value(setpointOption).toInt();
+    if (cfg.seconds > 0)
+        ok &= AcquisitionBench::run(cfg);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// parserbench.cpp
+// SCPI reply parser micro benchmark
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "parserbench.h"
+#include "benchreport.h"
+#include "allocationcounter.h"
+#include "scpireply.h"
+#include <QElapsedTimer>
+#include <QList>
+#include <QDebug>
+
+// keeps the compiler from optimizing the parsing away
+static volatile double sink;
+
+typedef struct {
+    const char  *name;
+    const char  *reply;     // as received, without '\n'
+    int         numbers;    // number of numeric fields
+} BENCH_CASE;
+
+static const BENCH_CASE cases[] = {
+    { "meas_all",   "12.34,0.500,6.170", 3 },
+    { "appl",       "12.00,1.000",       2 },
+    { "nr3",        "1.2340E+01,5.0000E-01,6.1700E+00", 3 },
+};
+
+typedef struct {
+    const char  *field;
+    bool        valid;
+    int         value;      // expected if valid
+} INTEGER_CASE;
+
+static const INTEGER_CASE integerCases[] = {
+    { "0",              true,   0 },
+    { "+17",            true,   17 },
+    { "-17",            true,   -17 },
+    { "2147483647",     true,   2147483647 },
+    { "-2147483648",    true,   -2147483647 - 1 },
+    { "2147483648",     false,  0 },
+    { "-2147483649",    false,  0 },
+    { "9999999999",     false,  0 },
+    { "99999999999999999999", false, 0 },
+    { "",               false,  0 },
+    { "-",              false,  0 },
+    { "1.5",            false,  0 },
+};
+
+static void report(const char *name, const char *parser, int iterations, qint64 ns, quint64 allocs)
+{
+    QJsonObject o;
+    o["bench"] = "parser";
+    o["case"] = name;
+    o["parser"] = parser;
+    o["iterations"] = iterations;
+    o["ns_per_reply"] = double(ns) / iterations;
+    o["allocs_per_reply"] = double(allocs) / iterations;
+    o["alloc_counting"] = AllocationCounter::method();
+    BenchReport::print(o);
+}
+
+bool ParserBench::run(int iterations)
+{
+    bool ok = true;
+    QElapsedTimer t;
+    for (const BENCH_CASE &c : cases) {
+        // ScpiReply straight from the receive buffer
+        ByteView view(c.reply);
+        quint64 a0 = AllocationCounter::count();
+        t.start();
+        for (int i=0; i<iterations; ++i) {
+            ScpiReply r(view);
+            double x, sum = 0;
+            while (r.nextNumber(x))
+                sum += x;
+            sink = sum;
+        }
+        qint64 ns = t.nsecsElapsed();
+        quint64 allocs = AllocationCounter::count() - a0;
+        report(c.name, "ScpiReply", iterations, ns, allocs);
+        if (allocs)
+            ok = false;
+
+        // former decoding: copy of the line, split() and toDouble() per field
+        QByteArray line(c.reply);
+        a0 = AllocationCounter::count();
+        t.start();
+        for (int i=0; i<iterations; ++i) {
+            QList<QByteArray> values = QByteArray(line.constData(), line.size()).split(',');
+            double sum = 0;
+            for (const QByteArray &v : values)
+                sum += v.trimmed().toDouble();
+            sink = sum;
+        }
+        ns = t.nsecsElapsed();
+        report(c.name, "QByteArray::split", iterations, ns, AllocationCounter::count() - a0);
+    }
+
+    // error queue reply with a quoted string
+    ByteView error("0,\"No error\"");
+    quint64 a0 = AllocationCounter::count();
+    t.start();
+    for (int i=0; i<iterations; ++i) {
+        ScpiReply r(error);
+        int code;
+        ByteView text;
+        if (r.nextInteger(code) && r.nextString(text))
+            sink = code + text.size();
+    }
+    qint64 ns = t.nsecsElapsed();
+    quint64 allocs = AllocationCounter::count() - a0;
+    report("syst_err", "ScpiReply", iterations, ns, allocs);
+    if (allocs)
+        ok = false;
+    return ok;
+}
+
+bool ParserBench::check()
+{
+    bool ok = true;
+    for (const INTEGER_CASE &c : integerCases) {
+        int x = 0;
+        bool valid = ScpiReply::toInteger(ByteView(c.field), x);
+        if ((valid != c.valid) || (valid && (x != c.value))) {
+            qCritical().nospace() << "toInteger(\"" << c.field << "\") returned " << valid << ", " << x;
+            ok = false;
+        }
+    }
+    return ok;
+}
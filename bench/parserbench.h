@@ -0,0 +1,25 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// parserbench.h
+// SCPI reply parser micro benchmark, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef PARSERBENCH_H
+#define PARSERBENCH_H
+
+namespace ParserBench
+{
+    // compares ScpiReply with the former QByteArray::split() decoding,
+    // returns false if ScpiReply allocated anything
+    bool run(int iterations);
+    // edge cases of the field conversions, returns false if any is decoded wrong
+    bool check();
+}
+
+#endif // PARSERBENCH_H
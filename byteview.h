@@ -0,0 +1,90 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// byteview.h
+// non-owning view into a byte buffer
+// the viewed data must stay valid as long as the view is used, views handed
+// out by SerDev::decodeLine() are valid during that call only
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef BYTEVIEW_H
+#define BYTEVIEW_H
+
+#include <QByteArray>
+#include <QString>
+#include <cstring>
+
+class ByteView
+{
+public:
+    ByteView() : m_data(nullptr), m_size(0) {}
+    ByteView(const char *data, int size) : m_data(data), m_size(size) {}
+    ByteView(const char *str) : m_data(str), m_size(str ? int(strlen(str)) : 0) {}
+    explicit ByteView(const QByteArray &a) : m_data(a.constData()), m_size(a.size()) {}
+
+    const char *data() const { return m_data; }
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    char at(int i) const { return m_data[i]; }
+    char operator[](int i) const { return m_data[i]; }
+    const char *begin() const { return m_data; }
+    const char *end() const { return m_data + m_size; }
+
+    ByteView mid(int pos, int len = -1) const
+    {
+        if (pos >= m_size)
+            return ByteView(m_data + m_size, 0);
+        if ((len < 0) || (len > m_size - pos))
+            len = m_size - pos;
+        return ByteView(m_data + pos, len);
+    }
+
+    ByteView left(int len) const { return mid(0, len); }
+
+    ByteView trimmed() const
+    {
+        int start = 0;
+        int stop = m_size;
+        while ((start < stop) && isSpace(m_data[start]))
+            ++start;
+        while ((stop > start) && isSpace(m_data[stop-1]))
+            --stop;
+        return ByteView(m_data + start, stop - start);
+    }
+
+    int indexOf(char c, int from = 0) const
+    {
+        if ((from < 0) || (from >= m_size))
+            return -1;
+        const void *p = memchr(m_data + from, c, size_t(m_size - from));
+        return p ? int(static_cast<const char *>(p) - m_data) : -1;
+    }
+
+    bool startsWith(const ByteView &other) const
+    {
+        return (other.m_size <= m_size) && ((other.m_size == 0) || !memcmp(m_data, other.m_data, size_t(other.m_size)));
+    }
+
+    bool operator==(const ByteView &other) const
+    {
+        return (other.m_size == m_size) && ((m_size == 0) || !memcmp(m_data, other.m_data, size_t(m_size)));
+    }
+    bool operator!=(const ByteView &other) const { return !operator==(other); }
+
+    // these allocate, use them for values that leave the decoder only
+    QByteArray toByteArray() const { return QByteArray(m_data, m_size); }
+    QString toString() const { return QString::fromLatin1(m_data, m_size); }
+
+private:
+    static bool isSpace(char c) { return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'); }
+
+    const char  *m_data;
+    int         m_size;
+};
+
+#endif // BYTEVIEW_H
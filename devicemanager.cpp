@@ -0,0 +1,295 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// devicemanager.cpp
+// many instruments polled from a few I/O threads
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "devicemanager.h"
+#include "dp700.h"
+#include "pollscheduler.h"
+#include "portwatcher.h"
+#include <QThread>
+#include <QTimer>
+#include <QFileInfo>
+#include <QDebug>
+#include <cstring>
+
+// a lost port is reopened after this delay, doubled with every failed attempt
+#define REOPEN_MIN_MS   500
+#define REOPEN_MAX_MS   30000
+
+DeviceManager::DeviceManager(int ioThreads, QObject *parent)
+    : QObject(parent)
+    , m_ioThreads(qMax(0, ioThreads))
+    , m_changes(0)
+    , m_stopped(false)
+    , m_portThread(nullptr)
+    , m_portWatcher(nullptr)
+{
+    qRegisterMetaType<SAMPLE>("SAMPLE");
+}
+
+DeviceManager::~DeviceManager()
+{
+    if (m_portThread) {
+        // the watcher is deleted when its thread finishes
+        m_portThread->quit();
+        m_portThread->wait();
+    }
+    stop();
+    for (int i=0; i<m_devices.size(); ++i) {
+        // the scheduler and the retry timer are children of the device
+        DP700 *dev = m_devices.at(i).dev;
+        runIn(i, [dev]() { delete dev; });
+        delete m_devices.at(i).reconnect;
+    }
+    for (QThread *t : qAsConst(m_threads)) {
+        t->quit();
+        t->wait();
+        delete t;
+    }
+}
+
+QString DeviceManager::stateName(DEVICE_STATE state)
+{
+    switch (state) {
+    case DeviceIdle:        return tr("idle");
+    case DeviceOpening:     return tr("opening");
+    case DeviceDetecting:   return tr("detecting baud rate");
+    case DevicePolling:     return tr("polling");
+    case DeviceNoReply:     return tr("no reply");
+    case DeviceReconnecting: return tr("reconnecting");
+    case DeviceFailed:      return tr("failed");
+    }
+    return QString();
+}
+
+int DeviceManager::addDevice(const DEVICE_CONFIG &cfg)
+{
+    int index = m_devices.size();
+    DEVICE d;
+    d.cfg = cfg;
+    d.dev = new DP700(cfg.port, cfg.baudRate ? cfg.baudRate : 9600);
+    d.scheduler = new PollScheduler(d.dev, d.dev);
+    d.dev->setProfile(cfg.profile);
+    d.scheduler->setMaxRate(cfg.maxRate);
+    d.retryTimer = new QTimer(d.dev);
+    d.retryTimer->setSingleShot(true);
+    d.reconnect = new RECONNECT;
+    d.reconnect->polled = false;
+    d.reconnect->retryMs = REOPEN_MIN_MS;
+    m_devices.append(d);
+
+    DEVICE_STATUS s;
+    s.port = cfg.port;
+    s.state = DeviceIdle;
+    s.baudRate = cfg.baudRate;
+    s.pollRate = 0;
+    s.channels = d.dev->channels();
+    memset(s.samples, 0, sizeof(s.samples));
+    memset(s.sample, 0, sizeof(s.sample));
+    m_lock.lock();
+    m_status.append(s);
+    m_lock.unlock();
+
+    // everything below runs in the device thread, the device is the context
+    DP700 *dev = d.dev;
+    connect(dev, &SerDev::opened, dev, [this, index, dev](bool ok) {
+        if (!ok) {
+            qWarning().nospace() << m_devices.at(index).cfg.port << ": cannot open serial port";
+            // a port that never worked is tried again only when it reappears
+            if (m_devices.at(index).reconnect->polled)
+                scheduleReopen(index);
+            else
+                setState(index, DeviceFailed);
+        } else if (m_devices.at(index).cfg.baudRate == 0) {
+            // after a reconnect the rate found before is the likely one
+            quint32 baudrate = status(index).baudRate;
+            setState(index, DeviceDetecting);
+            dev->detectBaudRate(baudrate ? baudrate : m_devices.at(index).cfg.preferredBaudRate);
+        } else {
+            startPolling(index);
+        }
+    });
+    connect(dev, &DP700::baudRateDetected, dev, [this, index](quint32 baudrate) {
+        m_lock.lock();
+        m_status[index].baudRate = baudrate;
+        m_lock.unlock();
+        startPolling(index);
+    });
+    connect(dev, &DP700::baudRateDetectionFailed, dev, [this, index]() {
+        // the instrument may still be powering up after a reconnect
+        if (m_devices.at(index).reconnect->polled)
+            scheduleReopen(index);
+        else
+            setState(index, DeviceFailed);
+    });
+    connect(dev, &SerDev::portError, dev, [this, index](const QString &text) {
+        qWarning().nospace() << m_devices.at(index).cfg.port << ": " << text;
+        m_devices.at(index).scheduler->stop();
+        m_devices.at(index).dev->close();
+        scheduleReopen(index);
+    });
+    connect(d.retryTimer, &QTimer::timeout, dev, [this, index]() { reopen(index); });
+    connect(dev, &DP700::linkLost, dev, [this, index]() { setState(index, DeviceNoReply); });
+    connect(dev, &DP700::resynced, dev, [this, index]() {
+        if (status(index).state == DeviceNoReply)
+            setState(index, DevicePolling);
+    });
+    connect(dev, &DP700::idn, dev, [this, index](const QString &x) {
+        QMutexLocker lock(&m_lock);
+        m_status[index].idn = x;
+        ++m_changes;
+    });
+    connect(d.scheduler, &PollScheduler::rateMeasured, dev, [this, index](double x) {
+        QMutexLocker lock(&m_lock);
+        m_status[index].pollRate = x;
+        ++m_changes;
+    });
+    connect(dev, &DP700::sampled, dev, [this, index](const SAMPLE &x) {
+        m_lock.lock();
+        m_status[index].sample[x.channel-1] = x;
+        m_status[index].samples[x.channel-1]++;
+        m_lock.unlock();
+        ++m_changes;
+        emit sampled(index, x);
+    });
+
+    if (m_ioThreads > 0) {
+        int t = index % m_ioThreads;
+        if (t >= m_threads.size()) {
+            QThread *thread = new QThread(this);
+            thread->setObjectName(QString("device I/O %1").arg(t));
+            thread->start();
+            m_threads.append(thread);
+        }
+        dev->moveToThread(m_threads.at(t));
+    }
+    return index;
+}
+
+DP700 *DeviceManager::device(int index) const
+{
+    return m_devices.at(index).dev;
+}
+
+QThread *DeviceManager::deviceThread(int index) const
+{
+    return m_devices.at(index).dev->thread();
+}
+
+DeviceManager::DEVICE_STATUS DeviceManager::status(int index) const
+{
+    QMutexLocker lock(&m_lock);
+    return m_status.at(index);
+}
+
+void DeviceManager::start()
+{
+    m_stopped = false;
+    for (int i=0; i<m_devices.size(); ++i) {
+        setState(i, DeviceOpening);
+        QMetaObject::invokeMethod(m_devices.at(i).dev, "open", Qt::QueuedConnection);
+    }
+}
+
+void DeviceManager::stop()
+{
+    m_stopped = true;
+    for (int i=0; i<m_devices.size(); ++i) {
+        PollScheduler *scheduler = m_devices.at(i).scheduler;
+        QTimer *retryTimer = m_devices.at(i).retryTimer;
+        runIn(i, [scheduler, retryTimer]() {
+            retryTimer->stop();
+            scheduler->stop();
+        });
+    }
+}
+
+void DeviceManager::watchPorts()
+{
+    if (m_portThread)
+        return;
+    m_portThread = new QThread(this);
+    m_portThread->setObjectName("serial port watcher");
+    m_portWatcher = new PortWatcher;
+    m_portWatcher->moveToThread(m_portThread);
+    connect(m_portThread, &QThread::finished, m_portWatcher, &QObject::deleteLater);
+    connect(m_portWatcher, &PortWatcher::portAdded, this, &DeviceManager::onPortAdded);
+    m_portThread->start();
+    QMetaObject::invokeMethod(m_portWatcher, "start", Qt::QueuedConnection);
+}
+
+void DeviceManager::onPortAdded(const QString &port)
+{
+    if (m_stopped)
+        return;
+    for (int i=0; i<m_devices.size(); ++i) {
+        // the watcher reports port names, the configuration may hold device paths
+        if (QFileInfo(m_devices.at(i).cfg.port).fileName() != port)
+            continue;
+        QMetaObject::invokeMethod(m_devices.at(i).dev, [this, i]() {
+            DEVICE_STATE state = status(i).state;
+            if ((state == DeviceReconnecting) || (state == DeviceFailed)) {
+                qInfo().nospace() << m_devices.at(i).cfg.port << ": serial port is available again";
+                m_devices.at(i).retryTimer->stop();
+                reopen(i);
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void DeviceManager::startPolling(int index)
+{
+    // called in the device thread
+    const DEVICE &d = m_devices.at(index);
+    d.reconnect->polled = true;
+    d.reconnect->retryMs = REOPEN_MIN_MS;
+    d.dev->queryInfo();
+    d.scheduler->start();
+    setState(index, DevicePolling);
+}
+
+void DeviceManager::scheduleReopen(int index)
+{
+    // called in the device thread
+    const DEVICE &d = m_devices.at(index);
+    setState(index, DeviceReconnecting);
+    if (m_stopped)
+        return;
+    d.retryTimer->start(d.reconnect->retryMs);
+    d.reconnect->retryMs = qMin(2 * d.reconnect->retryMs, REOPEN_MAX_MS);
+}
+
+void DeviceManager::reopen(int index)
+{
+    // called in the device thread
+    if (m_stopped)
+        return;
+    setState(index, DeviceOpening);
+    m_devices.at(index).dev->open();
+}
+
+void DeviceManager::setState(int index, DEVICE_STATE state)
+{
+    m_lock.lock();
+    m_status[index].state = state;
+    m_lock.unlock();
+    ++m_changes;
+    emit stateChanged(index, state);
+}
+
+void DeviceManager::runIn(int index, const std::function<void()> &f)
+{
+    DP700 *dev = m_devices.at(index).dev;
+    if (dev->thread() == QThread::currentThread())
+        f();
+    else
+        QMetaObject::invokeMethod(dev, f, Qt::BlockingQueuedConnection);
+}
@@ -0,0 +1,130 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// devicemanager.h
+// many instruments polled from a few I/O threads, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef DEVICEMANAGER_H
+#define DEVICEMANAGER_H
+
+#include <QObject>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#include "sample.h"
+#include "dp700.h"
+
+class PollScheduler;
+class PortWatcher;
+class QThread;
+class QTimer;
+
+// Every instrument gets its own DP700 and PollScheduler. Both are event
+// driven, so an I/O thread serves many instruments: it wakes up for serial
+// data and poll timers only. Devices are spread round robin over the threads.
+// Observers read status snapshots at their own pace instead of getting a
+// signal per measured value.
+class DeviceManager : public QObject
+{
+    Q_OBJECT
+public:
+    typedef enum {
+        DeviceIdle,
+        DeviceOpening,
+        DeviceDetecting,        // auto baud rate detection
+        DevicePolling,
+        DeviceNoReply,          // the port is open, the instrument does not answer
+        DeviceReconnecting,     // the port was lost, it is reopened after a while
+        DeviceFailed
+    } DEVICE_STATE;
+
+    typedef struct {
+        QString     port;
+        quint32     baudRate;       // 0: auto detect
+        quint32     preferredBaudRate;  // tried first when detecting
+        double      maxRate;        // poll cycles per second, 0: unlimited
+        const InstrumentProfile *profile;   // model, all its outputs are polled
+    } DEVICE_CONFIG;
+
+    typedef struct {
+        QString         port;
+        DEVICE_STATE    state;
+        quint32         baudRate;
+        double          pollRate;   // cycles per second
+        int             channels;
+        quint64         samples[DP700_MAX_CHANNELS];
+        SAMPLE          sample[DP700_MAX_CHANNELS];     // latest one, valid if samples > 0
+        QString         idn;
+    } DEVICE_STATUS;
+
+    // ioThreads <= 0: the devices live in the thread of the manager
+    explicit DeviceManager(int ioThreads = 1, QObject *parent = nullptr);
+    ~DeviceManager();
+
+    static QString stateName(DEVICE_STATE state);
+
+    // all devices must be added before start()
+    int addDevice(const DEVICE_CONFIG &cfg);
+    int count() const { return m_devices.size(); }
+    // lives in deviceThread(index), connect to it before start()
+    DP700 *device(int index) const;
+    QThread *deviceThread(int index) const;
+
+    // thread safe
+    DEVICE_STATUS status(int index) const;
+    // changes with every status update, lets a view skip unchanged frames
+    quint64 changes() const { return m_changes; }
+
+public slots:
+    void start();
+    // blocks until no device polls anymore
+    void stop();
+    // reopens devices as soon as their serial port reappears, call once after start()
+    void watchPorts();
+
+signals:
+    // emitted in the device thread
+    void sampled(int index, const SAMPLE &x);
+    void stateChanged(int index, int state);
+
+private:
+    // used in the device thread only
+    typedef struct {
+        bool            polled;         // polling started once, lost ports are reopened
+        int             retryMs;        // delay before the next reopen
+    } RECONNECT;
+
+    typedef struct {
+        DP700           *dev;
+        PollScheduler   *scheduler;
+        DEVICE_CONFIG   cfg;
+        QTimer          *retryTimer;    // child of dev
+        RECONNECT       *reconnect;
+    } DEVICE;
+
+    void onPortAdded(const QString &port);
+    void startPolling(int index);
+    void scheduleReopen(int index);
+    void reopen(int index);
+    void setState(int index, DEVICE_STATE state);
+    void runIn(int index, const std::function<void()> &f);
+
+    QVector<DEVICE>         m_devices;
+    QVector<QThread*>       m_threads;
+    int                     m_ioThreads;
+    mutable QMutex          m_lock;         // guards m_status
+    QVector<DEVICE_STATUS>  m_status;
+    std::atomic<quint64>    m_changes;
+    std::atomic<bool>       m_stopped;
+    QThread                 *m_portThread;
+    PortWatcher             *m_portWatcher;
+};
+
+#endif // DEVICEMANAGER_H
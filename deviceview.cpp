@@ -0,0 +1,170 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// deviceview.cpp
+// compact table of many instruments
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "deviceview.h"
+#include "devicemanager.h"
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QVBoxLayout>
+#include <QTimer>
+#include <QSettings>
+#include <QApplication>
+#include <cstring>
+
+#define PORTS_OPTION        "--ports"
+// the table is updated that often, whatever the poll rates are
+#define REFRESH_MS          200
+
+#define GRP_DP700           "DP700_Config"
+#define CFG_IO_THREADS      "ioThreads"
+#define CFG_MAX_POLL_RATE   "maxPollRate"
+#define CFG_DETECTED_BAUDRATE "DetectedBaudRate"
+#define CFG_MODEL           "model"
+#define CFG_PROFILES        "profiles"
+
+typedef enum {
+    ColPort,
+    ColState,
+    ColVoltage,
+    ColCurrent,
+    ColPower,
+    ColSetVoltage,
+    ColSetCurrent,
+    ColOutput,
+    ColRate,
+    COLUMNS
+} COLUMN;
+
+static const char *columnNames[COLUMNS] = {
+    "Port", "State", "U", "I", "P", "Set U", "Set I", "Output", "Polls/s"
+};
+
+DeviceView::DeviceView(const QStringList &ports, QWidget *parent)
+    : TMainWidget(parent)
+    , m_manager(nullptr)
+    , m_table(new QTableWidget(0, COLUMNS, this))
+    , m_refreshTimer(new QTimer(this))
+    , m_lastChanges(0)
+{
+    setObjectName("DeviceView");
+    QSettings cfg;
+    cfg.beginGroup(GRP_DP700);
+    // one I/O thread serves a dozen instruments easily
+    m_manager = new DeviceManager(qMax(1, cfg.value(CFG_IO_THREADS, 1).toInt()), this);
+    if (cfg.contains(CFG_PROFILES))
+        InstrumentProfile::load(cfg.value(CFG_PROFILES).toString());
+    // all instruments are of the same model
+    const InstrumentProfile *profile = InstrumentProfile::find(cfg.value(CFG_MODEL, "DP712").toString());
+    if (!profile)
+        profile = InstrumentProfile::find("DP712");
+    for (const QString &port : ports) {
+        DeviceManager::DEVICE_CONFIG d;
+        d.port = port;
+        d.baudRate = 0;
+        d.preferredBaudRate = cfg.value(CFG_DETECTED_BAUDRATE, 9600).toUInt();
+        d.maxRate = cfg.value(CFG_MAX_POLL_RATE, 0).toDouble();
+        d.profile = profile;
+        int index = m_manager->addDevice(d);
+        // one row per output
+        for (int ch=1; ch<=profile->channels(); ++ch) {
+            ROW r;
+            r.device = index;
+            r.channel = ch;
+            m_rows.append(r);
+        }
+    }
+    cfg.endGroup();
+
+    QStringList labels;
+    for (int c=0; c<COLUMNS; ++c)
+        labels << tr(columnNames[c]);
+    m_table->setHorizontalHeaderLabels(labels);
+    m_table->verticalHeader()->hide();
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+    m_table->setRowCount(m_rows.size());
+    for (int r=0; r<m_rows.size(); ++r) {
+        for (int c=0; c<COLUMNS; ++c) {
+            QTableWidgetItem *item = new QTableWidgetItem;
+            item->setTextAlignment((c <= ColState) ? (Qt::AlignLeft | Qt::AlignVCenter) : (Qt::AlignRight | Qt::AlignVCenter));
+            m_table->setItem(r, c, item);
+        }
+    }
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_table);
+    setWindowTitle(tr("%1 - %2 instruments").arg(qApp->applicationDisplayName()).arg(ports.size()));
+
+    refresh();
+    m_table->resizeColumnsToContents();
+    connect(m_refreshTimer, &QTimer::timeout, this, &DeviceView::refresh);
+    m_refreshTimer->start(REFRESH_MS);
+    m_manager->start();
+    m_manager->watchPorts();
+}
+
+DeviceView::~DeviceView()
+{
+    // stops and deletes the devices in their threads
+    delete m_manager;
+}
+
+QStringList DeviceView::requestedPorts(const QStringList &arguments)
+{
+    QStringList ports;
+    for (int i=1; i<arguments.size(); ++i) {
+        QString list;
+        if ((arguments.at(i) == PORTS_OPTION) && (i+1 < arguments.size()))
+            list = arguments.at(++i);
+        else if (arguments.at(i).startsWith(PORTS_OPTION "="))
+            list = arguments.at(i).mid(int(strlen(PORTS_OPTION "=")));
+        ports << list.split(',', Qt::SkipEmptyParts);
+    }
+    return ports;
+}
+
+void DeviceView::refresh()
+{
+    quint64 changes = m_manager->changes();
+    if (changes == m_lastChanges)
+        return;
+    m_lastChanges = changes;
+    DeviceManager::DEVICE_STATUS s;
+    int device = -1;
+    for (int r=0; r<m_rows.size(); ++r) {
+        if (m_rows.at(r).device != device) {
+            device = m_rows.at(r).device;
+            s = m_manager->status(device);
+        }
+        int ch = m_rows.at(r).channel;
+        setCell(r, ColPort, (s.channels > 1) ? QString("%1 CH%2").arg(s.port).arg(ch) : s.port);
+        m_table->item(r, ColPort)->setToolTip(s.idn);
+        setCell(r, ColState, DeviceManager::stateName(s.state));
+        bool valid = (s.samples[ch-1] > 0);
+        const SAMPLE &x = s.sample[ch-1];
+        setCell(r, ColVoltage, valid ? QString("%1 V").arg(x.voltage, 0, 'f', 2) : QString());
+        setCell(r, ColCurrent, valid ? QString("%1 A").arg(x.current, 0, 'f', 3) : QString());
+        setCell(r, ColPower, valid ? QString("%1 W").arg(x.power, 0, 'f', 2) : QString());
+        setCell(r, ColSetVoltage, valid ? QString("%1 V").arg(x.setVoltage, 0, 'f', 2) : QString());
+        setCell(r, ColSetCurrent, valid ? QString("%1 A").arg(x.setCurrent, 0, 'f', 3) : QString());
+        setCell(r, ColOutput, valid ? (x.on ? tr("ON") : tr("OFF")) : QString());
+        setCell(r, ColRate, (s.state == DeviceManager::DevicePolling) ? QString::number(s.pollRate, 'f', 1) : QString());
+    }
+}
+
+void DeviceView::setCell(int row, int column, const QString &text)
+{
+    // unchanged cells cause no repaint
+    QTableWidgetItem *item = m_table->item(row, column);
+    if (item->text() != text)
+        item->setText(text);
+}
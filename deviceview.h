@@ -0,0 +1,53 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// deviceview.h
+// compact table of many instruments, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef DEVICEVIEW_H
+#define DEVICEVIEW_H
+
+#include "tmainwidget.h"
+#include <QVector>
+
+class DeviceManager;
+class QTableWidget;
+class QTimer;
+
+// one row per instrument output, refreshed from status snapshots at a fixed rate,
+// so the GUI load does not grow with the poll rate of the instruments
+class DeviceView : public TMainWidget
+{
+    Q_OBJECT
+public:
+    explicit DeviceView(const QStringList &ports, QWidget *parent = nullptr);
+    ~DeviceView();
+
+    // ports given as "--ports COM3,COM4,...", empty if there are none
+    static QStringList requestedPorts(const QStringList &arguments);
+
+private slots:
+    void refresh();
+
+private:
+    typedef struct {
+        int     device;         // index in m_manager
+        int     channel;
+    } ROW;
+
+    void setCell(int row, int column, const QString &text);
+
+    DeviceManager   *m_manager;
+    QTableWidget    *m_table;
+    QVector<ROW>    m_rows;
+    QTimer          *m_refreshTimer;
+    quint64         m_lastChanges;
+};
+
+#endif // DEVICEVIEW_H
@@ -11,128 +11,813 @@
 // 2022-8-18  tt  Initial version created
 // ***************************************************************************
 #include "dp700.h"
+#include "scpireply.h"
 #include <QMutexLocker>
 #include <QDebug>
+#include <QTimer>
+#include <QThread>
+#include <QDateTime>
+#include <cstring>
+#include <cmath>
 
-DP700::DP700(const QString &port, QObject *parent)
-    : SerDev(port, 9600, parent)
-    , m_state(Idle)
+Q_LOGGING_CATEGORY(lcDevice, "dp700.device")
+Q_LOGGING_CATEGORY(lcScpi, "dp700.scpi")
+
+// number of queries that may wait for their reply at the same time
+#define MAX_IN_FLIGHT   4
+// refuse new commands if that many are still waiting to be sent in a lane
+#define MAX_PENDING     32
+// give up on compound queries if the first one is not answered in time
+#define BATCH_PROBE_MS  1000
+// time to wait for the *IDN? reply while probing a baud rate
+#define BAUD_PROBE_MS   300
+// update the link statistics display that often
+#define STATS_MS        1000
+// a streamed setpoint write not confirmed within that time no longer holds back the next one
+#define STREAM_BUSY_NS  1000000000LL
+// retry a streamed write refused by a full control lane after that time
+#define STREAM_RETRY_MS 50
+
+// command type names for the statistics, same order as CMD_TYPE
+static const char *cmdNames[] = {
+    "*IDN?", ":SYST:VERS?", ":MEAS:ALL?", ":OUTP:STAT?", ":APPL?", ":SYST:ERR?", "compound poll", "baud probe", "control", "resync"
+};
+
+// longest reply expected per command type, same order as CMD_TYPE; a compound
+// poll expects the sum of its parts per channel plus the :SYST:ERR? reply
+static const int replyBytes[] = {
+    64, 16, 24, 4, 28, 32, 0, 64, 2, 64
+};
+// time the instrument may take on top of the transfer, and the margin on the transfer
+#define DEADLINE_SLACK_NS   100000000LL
+#define DEADLINE_MARGIN     2
+// consecutive failed resyncs until the link is reported lost
+#define RESYNC_ATTEMPTS     3
+
+// parts of a sample received in the current poll cycle
+#define SAMPLE_MEASURED     0x01
+#define SAMPLE_ONOFF        0x02
+#define SAMPLE_SETPOINTS    0x04
+#define SAMPLE_COMPLETE     (SAMPLE_MEASURED | SAMPLE_ONOFF | SAMPLE_SETPOINTS)
+
+#define MAX_POLL_PARTS  (DP700_CHANNEL_QUERIES * DP700_MAX_CHANNELS + 1)
+
+DP700::DP700(const QString &port, quint32 baudrate, QObject *parent)
+    : SerDev(port, baudrate, parent)
+    , m_pollMode(PollBatchProbe)
+    , m_profile(nullptr)
+    , m_channels(0)
+    , m_batchProbeTimer(new QTimer(this))
+    , m_baudProbeTimer(new QTimer(this))
+    , m_stats(CMD_TYPES)
+    , m_statsTimer(new QTimer(this))
+    , m_replyTimer(new QTimer(this))
+    , m_resyncing(false)
+    , m_resyncSkip(0)
+    , m_resyncAttempts(0)
+    , m_streamBusy(false)
+    , m_streamIntervalNs(0)
+    , m_streamLastNs(0)
+    , m_streamTimer(new QTimer(this))
+{
+    qRegisterMetaType<SAMPLE>("SAMPLE");
+    memset(m_sample, 0, sizeof(m_sample));
+    memset(m_sampleParts, 0, sizeof(m_sampleParts));
+    memset(m_stream, 0, sizeof(m_stream));
+    setProfile(InstrumentProfile::find("DP712"));
+    m_clock.start();
+    m_batchProbeTimer->setSingleShot(true);
+    m_batchProbeTimer->setInterval(BATCH_PROBE_MS);
+    connect(m_batchProbeTimer, &QTimer::timeout, this, &DP700::onBatchProbeTimeout);
+    m_baudProbeTimer->setSingleShot(true);
+    m_baudProbeTimer->setInterval(BAUD_PROBE_MS);
+    connect(m_baudProbeTimer, &QTimer::timeout, this, &DP700::probeNextBaudRate);
+    m_statsTimer->setInterval(STATS_MS);
+    connect(m_statsTimer, &QTimer::timeout, this, &DP700::reportStatistics);
+    connect(this, &SerDev::opened, m_statsTimer, [this](bool ok) { if (ok) m_statsTimer->start(); });
+    m_streamTimer->setSingleShot(true);
+    connect(m_streamTimer, &QTimer::timeout, this, &DP700::flushStream);
+    m_replyTimer->setSingleShot(true);
+    m_replyTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_replyTimer, &QTimer::timeout, this, &DP700::onReplyTimeout);
+}
+
+QList<quint32> DP700::supportedBaudRates()
+{
+    // fastest first, this is the order used for auto detection
+    return QList<quint32>() << 115200 << 57600 << 38400 << 19200 << 9600 << 4800;
+}
+
+bool DP700::isBusy()
+{
+    QMutexLocker lock(&m_lock);
+    return !m_pending[LaneControl].isEmpty() || !m_pending[LanePoll].isEmpty() || !m_inFlight.isEmpty();
+}
+
+void DP700::setBatchedPoll(bool on)
+{
+    QMutexLocker lock(&m_lock);
+    if (!on || (m_profile->batching() == InstrumentProfile::BatchNever))
+        m_pollMode = PollChained;
+    else
+        m_pollMode = (m_profile->batching() == InstrumentProfile::BatchAlways) ? PollBatched : PollBatchProbe;
+}
+
+void DP700::setProfile(const InstrumentProfile *profile)
 {
+    m_lock.lock();
+    m_profile = profile;
+    m_channels = profile->channels();
+    buildPollCommands();
+    m_lock.unlock();
+    setBatchedPoll(true);
+}
+
+const InstrumentProfile *DP700::profile()
+{
+    QMutexLocker lock(&m_lock);
+    return m_profile;
+}
+
+int DP700::channels()
+{
+    QMutexLocker lock(&m_lock);
+    return m_channels;
+}
+
+void DP700::buildPollCommands()
+{
+    // m_lock must be held by the caller
+    for (int ch=0; ch<DP700_MAX_CHANNELS; ++ch)
+        m_sample[ch].channel = ch + 1;
+    // built once per profile, a poll cycle only shares these
+    if (!m_profile->channelQueries()) {
+        // single output instruments take the queries without channel
+        m_chainedPoll[0][0] = ":MEAS:ALL?\n";
+        m_chainedPoll[0][1] = ":OUTP:STAT?\n";
+        m_chainedPoll[0][2] = ":APPL?\n";
+    } else {
+        for (int ch=1; ch<=m_channels; ++ch) {
+            m_chainedPoll[ch-1][0] = QString(":MEAS:ALL? CH%1\n").arg(ch).toLatin1();
+            m_chainedPoll[ch-1][1] = QString(":OUTP:STAT? CH%1\n").arg(ch).toLatin1();
+            m_chainedPoll[ch-1][2] = QString(":APPL? CH%1\n").arg(ch).toLatin1();
+        }
+    }
+    // all channels in one message, one round trip per cycle whatever the channel count is
+    m_batchedPoll.clear();
+    for (int ch=1; ch<=m_channels; ++ch) {
+        for (int q=0; q<DP700_CHANNEL_QUERIES; ++q)
+            m_batchedPoll += m_chainedPoll[ch-1][q].left(m_chainedPoll[ch-1][q].size()-1) + ';';
+    }
+    m_batchedPoll += ":SYST:ERR?\n";
 }
 
 bool DP700::queryInfo()
 {
-    return sendCommand("*IDN?", Idle, QueryIdentification);
+    return sendCommand(CmdIdentification, "*IDN?", [this](const ByteView &reply) { emit idn(reply.toString()); })
+        && sendCommand(CmdVersion, ":SYST:VERS?", [this](const ByteView &reply) { emit version(reply.toString()); });
 }
 
 bool DP700::measureAll()
 {
-    return sendCommand(":MEAS:ALL?", Idle, MeasureAll);
+    static const QByteArray errorQuery(":SYST:ERR?\n");
+    m_lock.lock();
+    POLL_MODE mode = m_pollMode;
+    int channels = m_channels;
+    QByteArray batchedPoll = m_batchedPoll;
+    // setProfile() may replace the queries meanwhile, the copies are shared, not allocated
+    QByteArray chainedPoll[DP700_MAX_CHANNELS][DP700_CHANNEL_QUERIES];
+    if (mode == PollChained) {
+        for (int ch=0; ch<channels; ++ch) {
+            for (int q=0; q<DP700_CHANNEL_QUERIES; ++q)
+                chainedPoll[ch][q] = m_chainedPoll[ch][q];
+        }
+    }
+    m_lock.unlock();
+    if (mode != PollChained) {
+        // one write, one reply line for the complete poll cycle
+        if (!sendCommand(CmdBatchedPoll, batchedPoll, [this](const ByteView &reply) { decodeBatched(reply); }))
+            return false;
+        if (mode == PollBatchProbe)
+            m_batchProbeTimer->start();
+        return true;
+    }
+    // queue the complete poll cycle at once, the replies are matched in order
+    for (int ch=1; ch<=channels; ++ch) {
+        const QByteArray *q = chainedPoll[ch-1];
+        if (!sendCommand(CmdMeasureAll, q[0], [this, ch](const ByteView &reply) { decodeMeasureAll(ch, reply); })
+                || !sendCommand(CmdOnOff, q[1], [this, ch](const ByteView &reply) { decodeOnOff(ch, reply); })
+                || !sendCommand(CmdVoltageCurrent, q[2], [this, ch](const ByteView &reply) { decodeVoltageCurrent(ch, reply); }))
+            return false;
+    }
+    return sendCommand(CmdError, errorQuery, [this](const ByteView &reply) { decodeError(reply); completePoll(); });
+}
+
+bool DP700::setOnOff(bool on, int channel)
+{
+    char buf[PROFILE_COMMAND_SIZE];
+    m_lock.lock();
+    const InstrumentProfile *profile = m_profile;
+    m_lock.unlock();
+    if ((channel < 1) || (channel > profile->channels()))
+        return false;
+    return sendControl(buf, profile->encodeOutput(buf, channel, on));
+}
+
+bool DP700::setVoltageCurrent(double v, double c, int channel)
+{
+    return sendSetpoints(v, c, channel, REPLY_HANDLER());
 }
 
-bool DP700::setOnOff(bool on)
+bool DP700::sendSetpoints(double v, double c, int channel, const REPLY_HANDLER &done)
 {
-    return sendCommand(QString(":OUTP:STAT CH1,%1").arg(on ? "ON" : "OFF").toLatin1(), Idle, Idle);
+    char buf[PROFILE_COMMAND_SIZE];
+    m_lock.lock();
+    const InstrumentProfile *profile = m_profile;
+    m_lock.unlock();
+    if ((channel < 1) || (channel > profile->channels()))
+        return false;
+    // qBound() would turn NaN into the maximum
+    if (!std::isfinite(v) || !std::isfinite(c))
+        return false;
+    // never send anything outside the ratings of the output
+    const InstrumentProfile::RANGE &r = profile->range(channel);
+    v = qBound(r.minVoltage, v, r.maxVoltage);
+    c = qBound(0.0, c, r.maxCurrent);
+    return sendControl(buf, profile->encodeSetpoints(buf, channel, v, c), done);
 }
 
-bool DP700::setVoltageCurrent(double v, double c)
+void DP700::streamVoltageCurrent(double v, double c, int channel)
 {
-    return sendCommand(QString(":APPL CH1,%1,%2").arg(v, 0, 'f', 2).arg(c, 0, 'f', 2).toLatin1(), Idle, Idle);
+    // would never be accepted by sendSetpoints() and retried forever
+    if ((channel < 1) || (channel > DP700_MAX_CHANNELS) || !std::isfinite(v) || !std::isfinite(c))
+        return;
+    m_lock.lock();
+    // last write wins, values not written yet are simply replaced
+    STREAM_SETPOINTS &x = m_stream[channel-1];
+    x.voltage = v;
+    x.current = c;
+    x.pending = true;
+    m_lock.unlock();
+    if (QThread::currentThread() == thread())
+        flushStream();
+    else
+        QMetaObject::invokeMethod(this, "flushStream", Qt::QueuedConnection);
 }
 
-void DP700::decodeBuffer(QByteArray &buffer)
+void DP700::setStreamRate(double maxPerSecond)
 {
-    // check if there is a reply terminator in the received data
-    int inx;
-    while ((inx = buffer.indexOf('\n')) >= 0) {
-        decodeCommand(buffer.left(inx));
-        buffer = buffer.mid(inx+1);
+    QMutexLocker lock(&m_lock);
+    m_streamIntervalNs = (maxPerSecond > 0) ? qint64(1e9 / maxPerSecond) : 0;
+}
+
+void DP700::flushStream()
+{
+    QMutexLocker lock(&m_lock);
+    qint64 now = m_clock.nsecsElapsed();
+    // a write whose *OPC? got lost must not stop the stream for good
+    if (m_streamBusy && (now - m_streamLastNs < STREAM_BUSY_NS)) {
+        m_streamTimer->start(int((m_streamLastNs + STREAM_BUSY_NS - now) / 1000000) + 1);
+        return;
     }
+    m_streamBusy = false;
+    qint64 wait = m_streamLastNs + m_streamIntervalNs - now;
+    if (wait > 0) {
+        // the deadline does not move, restarting the timer only rearms it
+        m_streamTimer->start(int(wait / 1000000) + 1);
+        return;
+    }
+    m_streamTimer->stop();
+    bool failed = false;
+    for (int ch=1; ch<=DP700_MAX_CHANNELS; ++ch) {
+        STREAM_SETPOINTS &x = m_stream[ch-1];
+        if (!x.pending)
+            continue;
+        if (ch > m_profile->channels()) {
+            // the output does not exist, nothing to keep
+            x.pending = false;
+            continue;
+        }
+        double v = x.voltage;
+        double c = x.current;
+        m_streamBusy = true;
+        m_streamLastNs = now;
+        lock.unlock();
+        // one write at a time, the next one goes out when this one is done
+        bool ok = sendSetpoints(v, c, ch, [this](const ByteView &) {
+            m_lock.lock();
+            m_streamBusy = false;
+            m_lock.unlock();
+            flushStream();
+        });
+        lock.relock();
+        m_streamBusy = ok;
+        if (ok) {
+            // unless newer values came in meanwhile, they are the next to go
+            if ((x.voltage == v) && (x.current == c))
+                x.pending = false;
+            return;
+        }
+        failed = true;
+    }
+    // the control lane is full, the latest values are kept and tried again
+    if (failed)
+        m_streamTimer->start(STREAM_RETRY_MS);
 }
 
-void DP700::decodeCommand(const QByteArray &buffer)
+void DP700::detectBaudRate(quint32 preferred)
 {
-//    qDebug() << "+++ DP700::decodeCommand(buffer =" << buffer << ") +++";
-//    qDebug() << "      m_state =" << m_state;
-    switch(m_state) {
-    case QueryIdentification: {
-        sendCommand(":SYST:VERS?", m_state, privQueryVersion);
-        emit idn(buffer);
-        break;
+    m_probeRates = supportedBaudRates();
+    // try the last known good rate first to speed up the usual case
+    if (m_probeRates.removeOne(preferred))
+        m_probeRates.prepend(preferred);
+    probeNextBaudRate();
+}
+
+void DP700::probeNextBaudRate()
+{
+    QMutexLocker lock(&m_lock);
+    // drop whatever is left from the previous attempt
+    m_pending[LaneControl].clear();
+    m_pending[LanePoll].clear();
+    m_inFlight.clear();
+    m_resyncing = false;
+    m_resyncSkip = 0;
+    m_replyTimer->stop();
+    clearBuffers();
+    if (m_probeRates.isEmpty()) {
+        lock.unlock();
+        qWarning() << "no reply to *IDN? at any supported baud rate";
+        emit baudRateDetectionFailed();
+        return;
     }
-    case privQueryVersion: {
-        m_state = Idle;
-        emit version(buffer);
-        break;
+    quint32 baudrate = m_probeRates.takeFirst();
+    setBaudRate(baudrate);
+    lock.unlock();
+    qCDebug(lcDevice) << "probing" << baudrate << "baud";
+    sendCommand(CmdBaudProbe, "*IDN?", [this](const ByteView &reply) { decodeBaudProbe(reply); });
+    m_baudProbeTimer->start();
+}
+
+void DP700::close()
+{
+    QMutexLocker lock(&m_lock);
+    m_pending[LaneControl].clear();
+    m_pending[LanePoll].clear();
+    m_inFlight.clear();
+    m_resyncing = false;
+    m_resyncSkip = 0;
+    m_resyncAttempts = 0;
+    m_probeRates.clear();
+    m_replyTimer->stop();
+    m_batchProbeTimer->stop();
+    m_baudProbeTimer->stop();
+    m_streamBusy = false;
+    SerDev::close();
+}
+
+void DP700::decodeBaudProbe(const ByteView &reply)
+{
+    m_baudProbeTimer->stop();
+    if (reply.startsWith("RIGOL")) {
+        m_probeRates.clear();
+        qInfo() << "instrument answers at" << baudRate() << "baud";
+        emit baudRateDetected(baudRate());
+    } else {
+        // garbage from a wrong baud rate, try the next one
+        probeNextBaudRate();
     }
-    case MeasureAll: {
-        sendCommand(":OUTP:STAT?", m_state, privQueryOnOff);
-        QList<QByteArray> reply = buffer.split(',');
-        if (reply.size()==3) {
-            emit measuredVoltage(reply[0].trimmed().toDouble());
-            emit measuredCurrent(reply[1].trimmed().toDouble());
-            emit measuredPower(reply[2].trimmed().toDouble());
+}
+
+void DP700::decodeLine(const ByteView &line)
+{
+    decodeCommand(line);
+}
+
+void DP700::decodeCommand(const ByteView &reply)
+{
+    // nothing is formatted unless dp700.scpi debug messages are enabled
+    qCDebug(lcScpi) << "<-" << reply.toByteArray();
+    QMutexLocker lock(&m_lock);
+    if (m_inFlight.isEmpty()) {
+        qWarning() << "      unexpected data received";
+        return;
+    }
+    bool identification = reply.startsWith("RIGOL");
+    if (m_resyncing) {
+        // late replies to dropped commands, including the *IDN? ones dropped with them
+        if (!identification)
+            return;
+        if (m_resyncSkip > 0) {
+            --m_resyncSkip;
+            return;
         }
-        break;
+        m_resyncing = false;
+    } else if (identification && (m_inFlight.head().type != CmdIdentification)
+               && (m_inFlight.head().type != CmdBaudProbe) && (m_inFlight.head().type != CmdResync)) {
+        // a late reply to a marker given up before, never an answer to a poll or control command
+        qWarning() << "      late *IDN? reply dropped";
+        return;
+    } else if (m_inFlight.head().type != CmdResync) {
+        m_resyncAttempts = 0;
     }
-    case privQueryOnOff: {
-        emit onoff(buffer=="ON" ? true : false);
-        sendCommand(":APPL?", m_state, privQueryVoltageCurrent);
-        break;
+    // replies arrive in the order the queries were sent
+    COMMAND cmd = m_inFlight.dequeue();
+    armReplyTimer();
+    // control actions count from the request, that is what the user waits for;
+    // poll queries count the round trip only
+    m_stats.addLatency(cmd.type, m_clock.nsecsElapsed() - ((laneOf(cmd.type) == LaneControl) ? cmd.queuedNs : cmd.sentNs));
+    sendPending();
+    // the handler may queue new commands, so do not hold the lock while calling it
+    lock.unlock();
+    cmd.handler(reply);
+}
+
+void DP700::decodeMeasureAll(int channel, const ByteView &reply)
+{
+    ScpiReply r(reply);
+    double v, c, p;
+    if (r.nextNumber(v) && r.nextNumber(c) && r.nextNumber(p) && r.atEnd()) {
+        SAMPLE &x = m_sample[channel-1];
+        x.timestamp = QDateTime::currentMSecsSinceEpoch();
+        x.voltage = v;
+        x.current = c;
+        x.power = p;
+        m_sampleParts[channel-1] |= SAMPLE_MEASURED;
+        emit measuredVoltage(channel, v);
+        emit measuredCurrent(channel, c);
+        emit measuredPower(channel, p);
+    }
+}
+
+void DP700::decodeOnOff(int channel, const ByteView &reply)
+{
+    bool on;
+    if (ScpiReply(reply).nextBool(on)) {
+        m_sample[channel-1].on = on;
+        m_sampleParts[channel-1] |= SAMPLE_ONOFF;
+        emit onoff(channel, on);
+    }
+}
+
+void DP700::decodeVoltageCurrent(int channel, const ByteView &reply)
+{
+    ScpiReply r(reply);
+    double v, c;
+    ByteView label;
+    // multi output instruments put the channel and its ratings first, e.g. "CH1:30V/3A,5.000,1.000"
+    if (!ScpiReply(reply).nextNumber(v))
+        r.nextField(label);
+    if (r.nextNumber(v) && r.nextNumber(c) && r.atEnd()) {
+        m_sample[channel-1].setVoltage = v;
+        m_sample[channel-1].setCurrent = c;
+        m_sampleParts[channel-1] |= SAMPLE_SETPOINTS;
+        emit voltageSet(channel, v);
+        emit currentSet(channel, c);
     }
-    case privQueryVoltageCurrent: {
-        sendCommand(":SYST:ERR?", m_state, privGetError);
-        QList<QByteArray> reply = buffer.split(',');
-        if (reply.size()==2) {
-            emit voltageSet(reply[0].trimmed().toDouble());
-            emit currentSet(reply[1].trimmed().toDouble());
+}
+
+void DP700::decodeError(const ByteView &reply)
+{
+    // the usual "no error" reply is passed on without building a new string
+    static const QString noError = QStringLiteral("0,\"No error\"");
+    ScpiReply r(reply);
+    int code;
+    ByteView text;
+    if (r.nextInteger(code) && (code == 0) && r.nextString(text) && r.atEnd())
+        emit error(noError);
+    else
+        emit error(reply.trimmed().toString());
+}
+
+void DP700::decodeBatched(const ByteView &reply)
+{
+    m_batchProbeTimer->stop();
+    m_lock.lock();
+    int channels = m_channels;
+    m_lock.unlock();
+    int expected = DP700_CHANNEL_QUERIES * channels + 1;
+    // split the compound reply at ';', but not inside quoted strings
+    ByteView parts[MAX_POLL_PARTS];
+    int count = 0;
+    bool quoted = false;
+    int start = 0;
+    for (int i=0; (i<reply.size()) && (count<expected); ++i) {
+        if (reply.at(i) == '"') {
+            quoted = !quoted;
+        } else if ((reply.at(i) == ';') && !quoted) {
+            if (count == expected-1) {
+                // more parts than queries
+                count = expected+1;
+                break;
+            }
+            parts[count++] = reply.mid(start, i-start);
+            start = i+1;
         }
-        break;
     }
-    case privGetError: {
-        m_state = Idle;
-        emit error(buffer);
-        break;
+    if (count < expected)
+        parts[count++] = reply.mid(start);
+    if (count == expected) {
+        QMutexLocker lock(&m_lock);
+        if (m_pollMode == PollBatchProbe) {
+            m_pollMode = PollBatched;
+            lock.unlock();
+            qInfo() << "instrument accepts compound queries, polling in one message";
+        }
+        for (int ch=1; ch<=channels; ++ch) {
+            const ByteView *p = parts + DP700_CHANNEL_QUERIES*(ch-1);
+            decodeMeasureAll(ch, p[0]);
+            decodeOnOff(ch, p[1]);
+            decodeVoltageCurrent(ch, p[2]);
+        }
+        decodeError(parts[expected-1]);
+        completePoll();
+    } else {
+        QMutexLocker lock(&m_lock);
+        if (m_pollMode == PollBatchProbe) {
+            // the instrument answered the first query only, fall back to one query per write
+            m_pollMode = PollChained;
+            lock.unlock();
+            decodeMeasureAll(1, parts[0]);
+            // the other queries may still be answered line by line, realign before the
+            // next cycle, which is queued behind the marker
+            resync("compound query not supported, falling back to single queries");
+        } else {
+            lock.unlock();
+            qWarning() << "      malformed compound reply" << reply.toByteArray();
+        }
+        completePoll(false);
     }
-    case SetOnOff: {
-        m_state = Idle;
-        emit onoff(buffer=="ON" ? true : false);
-        break;
+}
+
+void DP700::onBatchProbeTimeout()
+{
+    QMutexLocker lock(&m_lock);
+    if (m_pollMode != PollBatchProbe)
+        return;
+    // no reply at all: the instrument rejected the compound message, or it is just slow;
+    // a late reply must not be taken for the answer to a single query
+    m_pollMode = PollChained;
+    lock.unlock();
+    m_stats.addTimeout();
+    resync("no reply to compound query, falling back to single queries");
+}
+
+void DP700::completePoll(bool answered)
+{
+    // cycles/s must drop when the instrument stops answering, the timeouts are counted instead
+    if (answered)
+        m_stats.addCycle();
+    for (int ch=0; ch<DP700_MAX_CHANNELS; ++ch) {
+        if (m_sampleParts[ch] == SAMPLE_COMPLETE)
+            emit sampled(m_sample[ch]);
+        m_sampleParts[ch] = 0;
     }
-    case SetVoltageCurrent: {
-        m_state = Idle;
-        QList<QByteArray> reply = buffer.split(',');
-        if (reply.size()==2) {
-            emit voltageSet(reply[0].trimmed().toDouble());
-            emit currentSet(reply[1].trimmed().toDouble());
+    emit pollComplete();
+}
+
+void DP700::reportStatistics()
+{
+    m_lock.lock();
+    CMD_TYPE pollType = (m_pollMode == PollChained) ? CmdMeasureAll : CmdBatchedPoll;
+    m_lock.unlock();
+    LinkStats::LATENCY l = m_stats.latency(pollType);
+    LinkStats::LATENCY control = m_stats.latency(CmdSet);
+    LinkStats::RATES r = m_stats.rates(m_clock.nsecsElapsed(), rxBytes(), txBytes());
+    QString summary = QString("%1: p50 %2 ms, p99 %3 ms | %4 cycles/s | rx %5 B/s, tx %6 B/s | %7 timeouts")
+            .arg(cmdNames[pollType])
+            .arg(l.p50, 0, 'f', 1)
+            .arg(l.p99, 0, 'f', 1)
+            .arg(r.cyclesPerSecond, 0, 'f', 1)
+            .arg(r.rxBytesPerSecond, 0, 'f', 0)
+            .arg(r.txBytesPerSecond, 0, 'f', 0)
+            .arg(m_stats.timeouts());
+    if (control.count)
+        summary += QString(" | control: p50 %1 ms, max %2 ms").arg(control.p50, 0, 'f', 1).arg(control.max, 0, 'f', 1);
+    emit statistics(summary);
+}
+
+void DP700::dumpStatistics()
+{
+    qInfo().nospace() << "link statistics at " << baudRate() << " baud, round trip latencies in ms:";
+    for (int type=0; type<CMD_TYPES; ++type) {
+        LinkStats::LATENCY l = m_stats.latency(type);
+        if (l.count == 0)
+            continue;
+        qInfo().noquote() << QString("    %1 n=%2  p50 %3  p95 %4  p99 %5  max %6")
+                             .arg(cmdNames[type], -14)
+                             .arg(l.count)
+                             .arg(l.p50, 0, 'f', 2)
+                             .arg(l.p95, 0, 'f', 2)
+                             .arg(l.p99, 0, 'f', 2)
+                             .arg(l.max, 0, 'f', 2);
+    }
+    qInfo().nospace() << "    " << rxBytes() << " bytes received, " << txBytes() << " bytes sent, " << m_stats.timeouts() << " timeouts";
+}
+
+bool DP700::sendCommand(CMD_TYPE type, const QByteArray &cmd, const REPLY_HANDLER &handler)
+{
+    COMMAND c;
+    c.type = type;
+    c.cmd = cmd;
+    if (!c.cmd.endsWith('\n'))
+        c.cmd.append('\n');
+    c.length = 0;
+    c.handler = handler;
+    return enqueue(&c, 1);
+}
+
+bool DP700::sendControl(const char *data, int length, const REPLY_HANDLER &done)
+{
+    static const QByteArray completeQuery("*OPC?\n");
+    // the set command is followed by *OPC?, its reply tells when the instrument has done it
+    COMMAND c[2];
+    c[0].type = CmdSet;
+    memcpy(c[0].data, data, size_t(length));
+    c[0].length = length;
+    c[1].type = CmdSet;
+    c[1].cmd = completeQuery;
+    c[1].length = 0;
+    c[1].handler = done;
+    if (!c[1].handler)
+        c[1].handler = [](const ByteView &) {};
+    return enqueue(c, 2);
+}
+
+bool DP700::enqueue(COMMAND *c, int count)
+{
+    if (lcScpi().isDebugEnabled()) {
+        for (int i=0; i<count; ++i)
+            qCDebug(lcScpi) << "->" << (c[i].length ? QByteArray(c[i].data, c[i].length) : c[i].cmd);
+    }
+    QMutexLocker lock(&m_lock);
+    QQueue<COMMAND> &lane = m_pending[laneOf(c[0].type)];
+    if (lane.size() + count > MAX_PENDING) {
+        qWarning() << "      command queue full, dropping" << (c[0].length ? QByteArray(c[0].data, c[0].length) : c[0].cmd);
+        return false;
+    }
+    qint64 now = m_clock.nsecsElapsed();
+    for (int i=0; i<count; ++i) {
+        c[i].queuedNs = now;
+        c[i].sentNs = 0;
+        lane.enqueue(c[i]);
+    }
+    if (QThread::currentThread() == thread()) {
+        sendPending();
+    } else {
+        // the serial port must only be touched from the device thread
+        QMetaObject::invokeMethod(this, "flushPending", Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void DP700::flushPending()
+{
+    QMutexLocker lock(&m_lock);
+    sendPending();
+}
+
+void DP700::sendPending()
+{
+    // m_lock must be held by the caller
+    for (int l=0; l<LANES; ++l) {
+        QQueue<COMMAND> &lane = m_pending[l];
+        while (!lane.isEmpty()) {
+            // commands without reply never block the queue, a blocked control
+            // lane holds back the poll lane as well
+            if (lane.head().handler && (m_inFlight.size() >= MAX_IN_FLIGHT))
+                return;
+            COMMAND cmd = lane.dequeue();
+            cmd.sentNs = m_clock.nsecsElapsed();
+            if (cmd.length)
+                sendData(cmd.data, cmd.length);
+            else
+                sendData(cmd.cmd);
+            if (cmd.handler) {
+                // replies come one after the other, so is their deadline
+                qint64 start = m_inFlight.isEmpty() ? cmd.sentNs : qMax(cmd.sentNs, m_inFlight.last().deadlineNs);
+                qint64 t = replyTimeNs(cmd);
+                cmd.deadlineNs = t ? start + t : 0;
+                m_inFlight.enqueue(cmd);
+                if (m_inFlight.size() == 1)
+                    armReplyTimer();
+            }
         }
-        break;
     }
-    default: {
-        m_state = Idle;
-        qWarning() << "      unexpected data received";
+}
+
+qint64 DP700::replyTimeNs(const COMMAND &cmd) const
+{
+    // m_lock must be held by the caller
+    int bytes;
+    switch (cmd.type) {
+    case CmdBaudProbe:
+        // has its own timer
+        return 0;
+    case CmdBatchedPoll:
+        if (m_pollMode == PollBatchProbe)
+            return 0;
+        bytes = m_channels * (replyBytes[CmdMeasureAll] + replyBytes[CmdOnOff] + replyBytes[CmdVoltageCurrent]) + replyBytes[CmdError];
+        break;
+    default:
+        bytes = replyBytes[cmd.type];
         break;
     }
-    }
+    bytes += cmd.length ? cmd.length : cmd.cmd.size();
+    // 10 bits per character, 8N1
+    return DEADLINE_MARGIN * qint64(bytes) * 10 * 1000000000LL / qMax<quint32>(baudRate(), 1) + DEADLINE_SLACK_NS;
+}
 
-//    qDebug() << "--- DP700::decodeCommand() ---";
+void DP700::armReplyTimer()
+{
+    // m_lock must be held by the caller, the first command with a deadline counts
+    for (const COMMAND &cmd : qAsConst(m_inFlight)) {
+        if (cmd.deadlineNs) {
+            qint64 ms = (cmd.deadlineNs - m_clock.nsecsElapsed()) / 1000000 + 1;
+            m_replyTimer->start(int(qMax<qint64>(ms, 0)));
+            return;
+        }
+    }
+    m_replyTimer->stop();
 }
 
+void DP700::onReplyTimeout()
+{
+    QMutexLocker lock(&m_lock);
+    qint64 now = m_clock.nsecsElapsed();
+    bool overdue = false;
+    CMD_TYPE type = CmdResync;
+    for (const COMMAND &cmd : qAsConst(m_inFlight)) {
+        if (cmd.deadlineNs) {
+            overdue = (now >= cmd.deadlineNs);
+            type = cmd.type;
+            break;
+        }
+    }
+    if (!overdue) {
+        armReplyTimer();
+        return;
+    }
+    lock.unlock();
+    m_stats.addTimeout();
+    resync(QString("no reply to %1 in time").arg(cmdNames[type]));
+}
 
-bool DP700::sendCommand(const QByteArray &cmd, STATE currentState, STATE newState)
+void DP700::resync(const QString &reason)
 {
-//    qDebug() << "+++ DP700::sendCommand(cmd =" << cmd << "currentState =" << currentState << "newState =" << newState << ") +++";
-//    qDebug() << "      m_state =" << m_state;
-    bool ret = false;
+    static const QByteArray marker("\n*IDN?\n");
     QMutexLocker lock(&m_lock);
-    if (m_state==currentState) {
-        ret = true;
-        m_state = newState;
-        QByteArray txData(cmd);
-        if (txData.right(1) != "\n")
-            txData.append('\n');
-        sendData(txData);
-    }
-//    qDebug() << "--- DP700::sendCommand() -> " << ret << "---";
-    return ret;
+    // find out what is lost before dropping it
+    bool pollLost = false;
+    bool streamLost = false;
+    // their late replies look like the marker's one
+    int skip = 0;
+    for (const COMMAND &cmd : qAsConst(m_inFlight)) {
+        pollLost |= (laneOf(cmd.type) == LanePoll) && (cmd.type != CmdIdentification) && (cmd.type != CmdVersion) && (cmd.type != CmdResync);
+        streamLost |= (cmd.type == CmdSet);
+        skip += ((cmd.type == CmdIdentification) || (cmd.type == CmdBaudProbe)) ? 1 : 0;
+    }
+    for (const COMMAND &cmd : qAsConst(m_pending[LanePoll]))
+        pollLost |= (cmd.type != CmdIdentification) && (cmd.type != CmdVersion);
+    // queries not written yet are dropped too, they belong to the poll cycle given up;
+    // control commands not written yet are kept
+    m_inFlight.clear();
+    m_pending[LanePoll].clear();
+    // control commands already handed to the port must still go out
+    clearInput();
+    if (streamLost)
+        m_streamBusy = false;
+    m_batchProbeTimer->stop();
+    bool lost = (++m_resyncAttempts == RESYNC_ATTEMPTS);
+    // a leading '\n' ends whatever partial command the instrument got. Only *IDN? replies
+    // start with "RIGOL": the marker's reply is the one after those of the dropped *IDN?
+    // queries. A late reply to an earlier marker is not counted, as that marker may never be
+    // answered; if it is taken for this one, this marker's reply is dropped in decodeCommand()
+    // as it arrives for a poll or control command.
+    COMMAND sync;
+    sync.type = CmdResync;
+    sync.cmd = marker;
+    sync.length = 0;
+    sync.handler = [this](const ByteView &) {
+        qInfo() << "link resynchronized";
+        emit resynced();
+    };
+    sync.queuedNs = sync.sentNs = m_clock.nsecsElapsed();
+    sync.deadlineNs = sync.sentNs + replyTimeNs(sync);
+    sendData(sync.cmd);
+    m_inFlight.enqueue(sync);
+    m_resyncing = true;
+    m_resyncSkip = skip;
+    armReplyTimer();
+    sendPending();
+    lock.unlock();
+
+    qWarning().noquote() << reason + ", resynchronizing";
+    if (lost) {
+        qWarning() << "instrument does not answer";
+        emit linkLost();
+    }
+    // let the scheduler go on with the next cycle, it is queued behind the marker
+    if (pollLost)
+        completePoll(false);
 }
@@ -16,52 +16,187 @@
 #include <QObject>
 #include "serdev.h"
 #include <QMutex>
+#include <QQueue>
+#include <QElapsedTimer>
+#include <functional>
+#include "linkstats.h"
+#include "sample.h"
+#include "instrumentprofile.h"
+#include <QLoggingCategory>
+
+class QTimer;
+
+// dp700.device: connection and baud rate detection
+// dp700.scpi:   every command sent and every reply received
+// dp700.poll:   poll cycle events
+Q_DECLARE_LOGGING_CATEGORY(lcDevice)
+Q_DECLARE_LOGGING_CATEGORY(lcScpi)
+// per cycle debug messages are off unless enabled by a rule
+#define DP700_LOG_RULES     "dp700.scpi.debug=false;dp700.poll.debug=false"
+// queries per channel in a poll cycle, followed by one :SYST:ERR?
+#define DP700_CHANNEL_QUERIES 3
 
 class DP700 : public SerDev
 {
     Q_OBJECT
 public:
-    explicit DP700(const QString &port, QObject *parent = nullptr);
+    explicit DP700(const QString &port, quint32 baudrate = 9600, QObject *parent = nullptr);
+
+    static QList<quint32> supportedBaudRates();
+
+    // these may be called from any thread
+    bool isBusy();
+    void setBatchedPoll(bool on);
+    // command set, ranges and channels of the instrument, DP712 if never set
+    void setProfile(const InstrumentProfile *profile);
+    const InstrumentProfile *profile();
+    // outputs polled in every cycle, as given by the profile
+    int channels();
 
 public slots:
+    // thread safe, commands are queued and written from the device thread
     bool queryInfo();
+    // channels count from 1
+    bool setOnOff(bool on, int channel = 1);
+    bool setVoltageCurrent(double v, double c, int channel = 1);
+    // live setpoints: only the latest values per channel are written, at most
+    // setStreamRate() times per second and never before the previous write is done
+    void streamVoltageCurrent(double v, double c, int channel = 1);
+    void setStreamRate(double maxPerSecond);
+    // to be called in the device thread only
     bool measureAll();
-    bool setOnOff(bool on);
-    bool setVoltageCurrent(double v, double c);
+    void detectBaudRate(quint32 preferred = 0);
+    void dumpStatistics();
+    // drops all queued commands, nothing is sent after the port is reopened
+    void close() override;
 
 signals:
-    void measuredVoltage(double x);
-    void measuredCurrent(double x);
-    void measuredPower(double x);
-    void voltageSet(double x);
-    void currentSet(double x);
+    void measuredVoltage(int channel, double x);
+    void measuredCurrent(int channel, double x);
+    void measuredPower(int channel, double x);
+    void voltageSet(int channel, double x);
+    void currentSet(int channel, double x);
     void error(const QString &x);
     void idn(const QString &x);
     void version(const QString &x);
-    void onoff(bool x);
+    void onoff(int channel, bool x);
+    void pollComplete();
+    // once per channel and poll cycle, x.channel tells which one
+    void sampled(const SAMPLE &x);
+    void baudRateDetected(quint32 baudrate);
+    void baudRateDetectionFailed();
+    void statistics(const QString &summary);
+    // a reply was overdue, the command queues have been realigned without reopening the port
+    void resynced();
+    // realigning failed several times in a row, the instrument does not answer
+    void linkLost();
+
+private slots:
+    void onBatchProbeTimeout();
+    void onReplyTimeout();
+    void probeNextBaudRate();
+    void flushPending();
+    void flushStream();
+    void reportStatistics();
 
 protected:
-    void decodeBuffer(QByteArray &buffer) override;
-    void decodeCommand(const QByteArray &buffer);
+    void decodeLine(const ByteView &line) override;
+    void decodeCommand(const ByteView &reply);
 
 private:
     typedef enum {
-        Idle,
-        QueryIdentification,
-        privQueryVersion,
-        MeasureAll,
-        privQueryOnOff,
-        SetOnOff,
-        privQueryVoltageCurrent,
-        SetVoltageCurrent,
-        privGetError
-    } STATE;
-
-    bool sendCommand(const QByteArray &cmd, STATE currentState, STATE newState);
-
-    QMutex      m_lock;
-    STATE       m_state;
+        PollChained,            // one query per write
+        PollBatchProbe,         // compound query sent, not yet known if the instrument accepts it
+        PollBatched             // compound query confirmed
+    } POLL_MODE;
+
+    typedef enum {
+        CmdIdentification,
+        CmdVersion,
+        CmdMeasureAll,
+        CmdOnOff,
+        CmdVoltageCurrent,
+        CmdError,
+        CmdBatchedPoll,
+        CmdBaudProbe,
+        CmdSet,
+        CmdResync,
+        CMD_TYPES
+    } CMD_TYPE;
+
+    // control actions are written before any poll query still waiting to be sent
+    typedef enum {
+        LaneControl,
+        LanePoll,
+        LANES
+    } LANE;
+
+    typedef std::function<void(const ByteView &reply)> REPLY_HANDLER;
+
+    typedef struct {
+        CMD_TYPE        type;
+        QByteArray      cmd;        // queries, shared with the precomputed ones
+        char            data[PROFILE_COMMAND_SIZE]; // set commands, encoded in place
+        int             length;     // of data, 0 if cmd is used
+        REPLY_HANDLER   handler;    // empty for commands without reply
+        qint64          queuedNs;   // m_clock time the command was requested
+        qint64          sentNs;     // m_clock time the command was written
+        qint64          deadlineNs; // m_clock time the reply is overdue, 0: no deadline
+    } COMMAND;
+
+    bool sendCommand(CMD_TYPE type, const QByteArray &cmd, const REPLY_HANDLER &handler = REPLY_HANDLER());
+    bool sendControl(const char *data, int length, const REPLY_HANDLER &done = REPLY_HANDLER());
+    bool sendSetpoints(double v, double c, int channel, const REPLY_HANDLER &done);
+    bool enqueue(COMMAND *c, int count);
+    static LANE laneOf(CMD_TYPE type) { return (type == CmdSet) ? LaneControl : LanePoll; }
+    void buildPollCommands();
+    qint64 replyTimeNs(const COMMAND &cmd) const;
+    void armReplyTimer();
+    void resync(const QString &reason);
+    void sendPending();
+    // answered: false if the cycle was given up, it lets the scheduler go on without being counted
+    void completePoll(bool answered = true);
+
+    void decodeMeasureAll(int channel, const ByteView &reply);
+    void decodeOnOff(int channel, const ByteView &reply);
+    void decodeVoltageCurrent(int channel, const ByteView &reply);
+    void decodeError(const ByteView &reply);
+    void decodeBatched(const ByteView &reply);
+    void decodeBaudProbe(const ByteView &reply);
 
+    QMutex          m_lock;             // guards the queues and the poll mode
+    QQueue<COMMAND> m_pending[LANES];   // commands waiting to be sent
+    QQueue<COMMAND> m_inFlight;     // commands sent, waiting for their reply
+    POLL_MODE       m_pollMode;
+    const InstrumentProfile *m_profile;
+    int             m_channels;
+    QByteArray      m_batchedPoll;      // complete poll cycle as one SCPI program message
+    // the same queries one by one
+    QByteArray      m_chainedPoll[DP700_MAX_CHANNELS][DP700_CHANNEL_QUERIES];
+    QTimer          *m_batchProbeTimer;
+    QList<quint32>  m_probeRates;       // baud rates still to try during detection
+    QTimer          *m_baudProbeTimer;
+    QElapsedTimer   m_clock;            // monotonic time base for the statistics
+    LinkStats       m_stats;
+    // collected during the current poll cycle, one per channel
+    SAMPLE          m_sample[DP700_MAX_CHANNELS];
+    quint32         m_sampleParts[DP700_MAX_CHANNELS];
+    QTimer          *m_statsTimer;
+    QTimer          *m_replyTimer;      // fires at the deadline of the oldest command in flight
+    bool            m_resyncing;        // replies are dropped until the resync marker is answered
+    int             m_resyncSkip;       // late *IDN? replies to drop before the marker's one
+    int             m_resyncAttempts;   // in a row, without a regular reply in between
+    // live setpoints, guarded by m_lock
+    typedef struct {
+        double  voltage;
+        double  current;
+        bool    pending;            // not written yet
+    } STREAM_SETPOINTS;
+    STREAM_SETPOINTS m_stream[DP700_MAX_CHANNELS];
+    bool            m_streamBusy;       // a streamed write waits for its *OPC?
+    qint64          m_streamIntervalNs; // 0: as fast as the instrument confirms
+    qint64          m_streamLastNs;     // m_clock time of the last streamed write
+    QTimer          *m_streamTimer;
 };
 
 #endif // DP700_H
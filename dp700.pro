@@ -28,9 +28,22 @@ SOURCES += \
     mainwidget.cpp \
     tmainwidget.cpp \
     tmessagehandler.cpp \
+    tlogwriter.cpp \
     tapp.cpp \
     serdev.cpp \
-    tpowereventfilter.cpp
+    tpowereventfilter.cpp \
+    pollscheduler.cpp \
+    scpireply.cpp \
+    linkstats.cpp \
+    headless.cpp \
+    samplerecorder.cpp \
+    samplearchive.cpp \
+    trendhistory.cpp \
+    trendplot.cpp \
+    devicemanager.cpp \
+    deviceview.cpp \
+    instrumentprofile.cpp \
+    portwatcher.cpp
 
 HEADERS += \
     dp700.h \
@@ -38,10 +51,27 @@ HEADERS += \
     tmainwidget.h \
     tmessagehandler.h \
     tmsghandler_main.h \
+    tlogwriter.h \
+    tlogrecord.h \
+    tmpscqueue.h \
     tapp.h \
     silentcall.h \
     serdev.h \
-    tpowereventfilter.h
+    tpowereventfilter.h \
+    pollscheduler.h \
+    byteview.h \
+    scpireply.h \
+    linkstats.h \
+    sample.h \
+    headless.h \
+    samplerecorder.h \
+    samplearchive.h \
+    trendhistory.h \
+    trendplot.h \
+    devicemanager.h \
+    deviceview.h \
+    instrumentprofile.h \
+    portwatcher.h
 
 FORMS += \
     mainwidget.ui
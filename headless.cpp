@@ -0,0 +1,423 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// headless.cpp
+// acquisition without GUI, controlled by command line arguments
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "headless.h"
+#include "dp700.h"
+#include "devicemanager.h"
+#include "samplerecorder.h"
+#include "samplearchive.h"
+#include "tlogrecord.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QFile>
+#include <QTimer>
+#include <QRegExp>
+#include <QDebug>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#define HEADLESS_OPTION "--headless"
+
+// stdout belongs to the samples, all messages go to stderr
+// only messages of enabled categories get here, see --log-rules
+static void headlessMessageHandler(QtMsgType t, const QMessageLogContext &context, const QString &msg)
+{
+    TLOG_RECORD r;
+    r.type = t;
+    r.category = context.category;
+    r.text = msg;
+    r.repeat = 0;
+    r.firstTime = r.lastTime = QDateTime::currentMSecsSinceEpoch();
+    fprintf(stderr, "%s %s\n", qPrintable(tLogTimeTag(r.lastTime)), qPrintable(tLogText(r)));
+    fflush(stderr);
+    if (t == QtFatalMsg)
+        abort();
+}
+
+Headless::Headless(QObject *parent)
+    : QObject(parent)
+    , m_manager(nullptr)
+    , m_setVoltage(NAN)
+    , m_setCurrent(NAN)
+    , m_setOutput(-1)
+    , m_channels(1)
+    , m_channel(1)
+    , m_count(0)
+    , m_samples(0)
+    , m_dumpStats(false)
+{
+    qInstallMessageHandler(headlessMessageHandler);
+}
+
+Headless::~Headless()
+{
+    // stops the devices before the recorders and archives go away
+    delete m_manager;
+    for (const DEVICE &d : qAsConst(m_devices)) {
+        for (int ch=0; ch<DP700_MAX_CHANNELS; ++ch) {
+            delete d.recorder[ch];
+            delete d.archive[ch];
+        }
+    }
+    qDeleteAll(m_sinks);
+}
+
+bool Headless::isRequested(int argc, char *argv[])
+{
+    for (int i=1; i<argc; ++i) {
+        if (!strcmp(argv[i], HEADLESS_OPTION))
+            return true;
+    }
+    return false;
+}
+
+bool Headless::start(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("DP700 acquisition without GUI, samples are written as CSV lines:\n"
+                                     "time_ms,voltage,current,power,set_voltage,set_current,output\n"
+                                     "with more than one --port every line starts with the port name,\n"
+                                     "with more than one channel the channel follows before the time,\n"
+                                     "recordings and archives get one file per port and channel,\n"
+                                     "named <file>.<port>.ch<channel>");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption headlessOption("headless", "run without GUI");
+    QCommandLineOption portOption(QStringList() << "p" << "port", "serial port, may be repeated", "name");
+    QCommandLineOption baudOption(QStringList() << "b" << "baud", "baud rate or 'auto'", "rate", "auto");
+    QCommandLineOption rateOption(QStringList() << "r" << "rate", "maximum poll cycles per second, 0: unlimited", "cycles", "0");
+    QCommandLineOption voltageOption("set-voltage", "voltage setpoint", "V");
+    QCommandLineOption currentOption("set-current", "current setpoint", "A");
+    QCommandLineOption outputOption("output", "switch the output 'on' or 'off'", "state");
+    QCommandLineOption outOption(QStringList() << "o" << "out", "write samples to file, '-' for stdout (default without --record), may be repeated", "file");
+    QCommandLineOption recordOption("record", "append samples to a binary memory mapped recording", "file");
+    QCommandLineOption archiveOption("archive", "append samples to a compressed long-term archive", "file");
+    QCommandLineOption extractOption("extract", "write the samples of an archive as CSV instead of acquiring", "file");
+    QCommandLineOption fromOption("from", "first sample to extract, ISO date/time or ms since epoch", "time");
+    QCommandLineOption toOption("to", "last sample to extract, ISO date/time or ms since epoch", "time");
+    QCommandLineOption countOption(QStringList() << "n" << "count", "stop after that many samples per port", "n", "0");
+    QCommandLineOption durationOption(QStringList() << "t" << "duration", "stop after that many seconds", "s", "0");
+    QCommandLineOption statsOption("stats", "log link statistics when done");
+    QCommandLineOption modelOption("model", "instrument model, all its outputs are polled: " + InstrumentProfile::models().join(", "), "name", "DP712");
+    QCommandLineOption profilesOption("profiles", "INI file with user defined instrument models", "file");
+    QCommandLineOption channelOption("channel", "output the setpoints are for", "n", "1");
+    QCommandLineOption threadsOption("io-threads", "threads serving the serial ports, 0: the main thread", "n", "0");
+    QCommandLineOption logRulesOption("log-rules", "logging category rules separated by ';', e.g. 'dp700.scpi.debug=true'", "rules");
+    parser.addOptions(QList<QCommandLineOption>() << headlessOption << portOption << baudOption << rateOption
+                      << voltageOption << currentOption << outputOption << outOption << recordOption
+                      << archiveOption << extractOption << fromOption << toOption
+                      << countOption << durationOption << statsOption << modelOption << profilesOption << channelOption << threadsOption << logRulesOption);
+    parser.process(arguments);
+    tSetLogRules(QString(DP700_LOG_RULES) + ';' + parser.value(logRulesOption));
+
+    if (parser.isSet(extractOption)) {
+        qint64 from = std::numeric_limits<qint64>::min();
+        qint64 to = std::numeric_limits<qint64>::max();
+        if ((parser.isSet(fromOption) && !parseTime(parser.value(fromOption), from))
+                || (parser.isSet(toOption) && !parseTime(parser.value(toOption), to))) {
+            qCritical() << "--from and --to take an ISO date/time or ms since epoch";
+            return false;
+        }
+        QStringList outputs = parser.values(outOption);
+        if (outputs.isEmpty())
+            outputs << "-";
+        if (!openSinks(outputs) || !extract(parser.value(extractOption), from, to))
+            return false;
+        // nothing to wait for
+        QMetaObject::invokeMethod(QCoreApplication::instance(), "quit", Qt::QueuedConnection);
+        return true;
+    }
+
+    QStringList ports = parser.values(portOption);
+    if (ports.isEmpty()) {
+        qCritical() << "no serial port given, use --port";
+        return false;
+    }
+    quint32 baudrate = 0;
+    if (parser.value(baudOption) != "auto") {
+        baudrate = parser.value(baudOption).toUInt();
+        if (!DP700::supportedBaudRates().contains(baudrate)) {
+            qCritical() << "unsupported baud rate" << parser.value(baudOption);
+            return false;
+        }
+    }
+    // a typo must never end up as 0 V or 0 A at the instrument
+    bool ok = true;
+    if (parser.isSet(voltageOption))
+        m_setVoltage = parser.value(voltageOption).toDouble(&ok);
+    if (!ok || (parser.isSet(voltageOption) && !std::isfinite(m_setVoltage))) {
+        qCritical() << "invalid voltage" << parser.value(voltageOption);
+        return false;
+    }
+    if (parser.isSet(currentOption))
+        m_setCurrent = parser.value(currentOption).toDouble(&ok);
+    if (!ok || (parser.isSet(currentOption) && !std::isfinite(m_setCurrent))) {
+        qCritical() << "invalid current" << parser.value(currentOption);
+        return false;
+    }
+    if (parser.isSet(outputOption)) {
+        QString state = parser.value(outputOption).toLower();
+        if ((state != "on") && (state != "off")) {
+            qCritical() << "--output must be 'on' or 'off'";
+            return false;
+        }
+        m_setOutput = (state == "on") ? 1 : 0;
+    }
+    if (parser.isSet(profilesOption) && (InstrumentProfile::load(parser.value(profilesOption)) < 0))
+        return false;
+    const InstrumentProfile *profile = InstrumentProfile::find(parser.value(modelOption));
+    if (!profile) {
+        qCritical() << "unknown model" << parser.value(modelOption) << "- known are" << InstrumentProfile::models().join(", ");
+        return false;
+    }
+    m_channels = profile->channels();
+    m_channel = parser.value(channelOption).toInt();
+    if ((m_channel < 1) || (m_channel > m_channels)) {
+        qCritical() << "--channel must be 1 ..." << m_channels << "for" << profile->model();
+        return false;
+    }
+    m_count = parser.value(countOption).toLongLong();
+    m_dumpStats = parser.isSet(statsOption);
+
+    m_manager = new DeviceManager(parser.value(threadsOption).toInt());
+    for (const QString &port : qAsConst(ports)) {
+        DeviceManager::DEVICE_CONFIG cfg;
+        cfg.port = port;
+        cfg.baudRate = baudrate;
+        cfg.preferredBaudRate = 0;
+        cfg.maxRate = parser.value(rateOption).toDouble();
+        cfg.profile = profile;
+        int index = m_manager->addDevice(cfg);
+
+        DEVICE d;
+        // no port column and no file name suffix for a single device
+        d.port = (ports.size() > 1) ? port : QString();
+        d.setpointsSent = false;
+        d.samples = 0;
+        for (int ch=0; ch<DP700_MAX_CHANNELS; ++ch) {
+            d.recorder[ch] = nullptr;
+            d.archive[ch] = nullptr;
+        }
+        // added before opening, so the destructor cleans up after errors
+        m_devices.append(d);
+        DEVICE &added = m_devices.last();
+        for (int ch=1; ch<=m_channels; ++ch) {
+            int fileChannel = (m_channels > 1) ? ch : 0;
+            if (parser.isSet(recordOption)) {
+                added.recorder[ch-1] = new SampleRecorder;
+                if (!added.recorder[ch-1]->open(fileFor(parser.value(recordOption), d.port, fileChannel)))
+                    return false;
+            }
+            if (parser.isSet(archiveOption)) {
+                added.archive[ch-1] = new SampleArchive;
+                if (!added.archive[ch-1]->open(fileFor(parser.value(archiveOption), d.port, fileChannel)))
+                    return false;
+            }
+        }
+
+        DP700 *dev = m_manager->device(index);
+        QString name = port + ":";
+        connect(dev, &DP700::idn, this, [name](const QString &x) { qInfo() << qPrintable(name) << "Identification:" << x; });
+        connect(dev, &DP700::version, this, [name](const QString &x) { qInfo() << qPrintable(name) << "Version:" << x; });
+        connect(dev, &DP700::error, this, [name](const QString &x) { if (x!="0,\"No error\"") qCritical() << qPrintable(name) << "Error:" << x; });
+        // the recorders are written in the device thread, see finish()
+        if (parser.isSet(recordOption) || parser.isSet(archiveOption)) {
+            DEVICE files = added;
+            connect(dev, &DP700::sampled, dev, [files](const SAMPLE &x) {
+                if (files.recorder[x.channel-1])
+                    files.recorder[x.channel-1]->append(x);
+                if (files.archive[x.channel-1])
+                    files.archive[x.channel-1]->append(x);
+            }, Qt::DirectConnection);
+        }
+    }
+    QStringList outputs = parser.values(outOption);
+    if (outputs.isEmpty() && !parser.isSet(recordOption) && !parser.isSet(archiveOption))
+        outputs << "-";
+    if (!openSinks(outputs))
+        return false;
+
+    double duration = parser.value(durationOption).toDouble();
+    if (duration > 0)
+        QTimer::singleShot(int(duration * 1000), this, &Headless::finish);
+
+    connect(m_manager, &DeviceManager::stateChanged, this, &Headless::onStateChanged);
+    connect(m_manager, &DeviceManager::sampled, this, &Headless::onSampled);
+    m_manager->start();
+    m_manager->watchPorts();
+    return true;
+}
+
+QString Headless::fileFor(const QString &fileName, const QString &port, int channel)
+{
+    QString name = fileName;
+    if (!port.isEmpty())
+        name += "." + QString(port).replace(QRegExp("[^A-Za-z0-9]"), "_");
+    if (channel > 0)
+        name += QString(".ch%1").arg(channel);
+    return name;
+}
+
+bool Headless::openSinks(const QStringList &names)
+{
+    for (const QString &name : names) {
+        QFile *f = new QFile(name == "-" ? QString() : name);
+        bool ok = (name == "-") ? f->open(stdout, QIODevice::WriteOnly) : f->open(QIODevice::WriteOnly | QIODevice::Append);
+        if (!ok) {
+            qCritical() << "cannot open" << name << "for writing";
+            delete f;
+            return false;
+        }
+        m_sinks.append(f);
+    }
+    return true;
+}
+
+bool Headless::parseTime(const QString &text, qint64 &ms)
+{
+    bool ok;
+    ms = text.toLongLong(&ok);
+    if (ok)
+        return true;
+    QDateTime t = QDateTime::fromString(text, Qt::ISODateWithMs);
+    if (!t.isValid())
+        return false;
+    ms = t.toMSecsSinceEpoch();
+    return true;
+}
+
+bool Headless::extract(const QString &fileName, qint64 from, qint64 to)
+{
+    SampleArchiveReader archive;
+    if (!archive.open(fileName))
+        return false;
+    qInfo().nospace() << fileName << ": " << archive.samples() << " samples in " << archive.blocks() << " blocks, "
+                      << QDateTime::fromMSecsSinceEpoch(archive.firstTime()).toString(Qt::ISODate) << " to "
+                      << QDateTime::fromMSecsSinceEpoch(archive.lastTime()).toString(Qt::ISODate);
+    QVector<SAMPLE> samples;
+    bool ok = archive.read(from, to, samples);
+    for (const SAMPLE &x : samples)
+        writeSample(x);
+    qInfo() << samples.size() << "samples extracted";
+    return ok;
+}
+
+void Headless::onStateChanged(int index, int state)
+{
+    if (state == DeviceManager::DeviceFailed) {
+        for (int i=0; i<m_manager->count(); ++i) {
+            if (m_manager->status(i).state != DeviceManager::DeviceFailed)
+                return;
+        }
+        qCritical() << "no instrument answers";
+        QCoreApplication::exit(1);
+    } else if ((state == DeviceManager::DevicePolling) && !m_devices.at(index).setpointsSent) {
+        // once per run, a reconnected instrument keeps its settings
+        DP700 *dev = m_manager->device(index);
+        // both setpoints known: send them right away, otherwise wait for the first sample
+        if (!std::isnan(m_setVoltage) && !std::isnan(m_setCurrent)) {
+            dev->setVoltageCurrent(m_setVoltage, m_setCurrent, m_channel);
+            if (m_setOutput >= 0)
+                dev->setOnOff(m_setOutput == 1, m_channel);
+            m_devices[index].setpointsSent = true;
+        } else if (std::isnan(m_setVoltage) && std::isnan(m_setCurrent)) {
+            if (m_setOutput >= 0)
+                dev->setOnOff(m_setOutput == 1, m_channel);
+            m_devices[index].setpointsSent = true;
+        }
+    }
+}
+
+void Headless::onSampled(int index, const SAMPLE &x)
+{
+    DEVICE &d = m_devices[index];
+    if (!d.setpointsSent && (x.channel == m_channel)) {
+        // only one of the setpoints was given, keep the other one
+        DP700 *dev = m_manager->device(index);
+        dev->setVoltageCurrent(std::isnan(m_setVoltage) ? x.setVoltage : m_setVoltage,
+                               std::isnan(m_setCurrent) ? x.setCurrent : m_setCurrent, m_channel);
+        if (m_setOutput >= 0)
+            dev->setOnOff(m_setOutput == 1, m_channel);
+        d.setpointsSent = true;
+    }
+    writeSample(x, d.port, m_channels > 1);
+    ++m_samples;
+    // every poll cycle delivers channel 1
+    if (x.channel != 1)
+        return;
+    ++d.samples;
+    if ((m_count > 0) && (d.samples == m_count)) {
+        for (const DEVICE &other : qAsConst(m_devices)) {
+            if (other.samples < m_count)
+                return;
+        }
+        finish();
+    }
+}
+
+void Headless::writeSample(const SAMPLE &x, const QString &port, bool withChannel)
+{
+    char channel[16] = "";
+    if (withChannel)
+        snprintf(channel, sizeof(channel), "%d,", x.channel);
+    char line[240];
+    int n = snprintf(line, sizeof(line), "%s%s%s%lld,%.3f,%.3f,%.3f,%.3f,%.3f,%d\n",
+                     qPrintable(port), port.isEmpty() ? "" : ",", channel,
+                     static_cast<long long>(x.timestamp), x.voltage, x.current, x.power,
+                     x.setVoltage, x.setCurrent, x.on ? 1 : 0);
+    if (n < 0) {
+        qWarning() << "cannot format sample of" << port;
+        return;
+    }
+    if (n >= int(sizeof(line))) {
+        // snprintf() tells the length the line would have had, keep what fits and end the line
+        n = int(sizeof(line)) - 1;
+        line[n-1] = '\n';
+    }
+    for (QFile *f : m_sinks) {
+        f->write(line, n);
+        // keep the files tailable
+        f->flush();
+    }
+}
+
+void Headless::finish()
+{
+    m_manager->stop();
+    for (int i=0; i<m_devices.size(); ++i) {
+        const DEVICE &d = m_devices.at(i);
+        DP700 *dev = m_manager->device(i);
+        if (m_dumpStats) {
+            qInfo() << qPrintable(m_manager->status(i).port + ":");
+            QMetaObject::invokeMethod(dev, "dumpStatistics",
+                                      (dev->thread() == thread()) ? Qt::DirectConnection : Qt::BlockingQueuedConnection);
+        }
+        // a poll cycle still in flight may deliver one more sample in the device thread
+        auto close = [d]() {
+            for (int ch=0; ch<DP700_MAX_CHANNELS; ++ch) {
+                if (d.recorder[ch])
+                    d.recorder[ch]->close();
+                if (d.archive[ch])
+                    d.archive[ch]->close();
+            }
+        };
+        if (dev->thread() == thread())
+            close();
+        else
+            QMetaObject::invokeMethod(dev, close, Qt::BlockingQueuedConnection);
+    }
+    qInfo() << m_samples << "samples written";
+    QCoreApplication::quit();
+}
@@ -0,0 +1,75 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// headless.h
+// acquisition without GUI, controlled by command line arguments, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include "sample.h"
+#include "dp700.h"
+
+class DeviceManager;
+class SampleRecorder;
+class SampleArchive;
+class QFile;
+
+class Headless : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Headless(QObject *parent = nullptr);
+    ~Headless();
+
+    // true if the command line asks for headless operation, checked before
+    // any application object exists
+    static bool isRequested(int argc, char *argv[]);
+
+    // parse the arguments and start acquisition, false on errors
+    bool start(const QStringList &arguments);
+
+private slots:
+    void onStateChanged(int index, int state);
+    void onSampled(int index, const SAMPLE &x);
+    void finish();
+
+private:
+    typedef struct {
+        QString         port;           // empty with a single device
+        // one per channel, nullptr if not recording or archiving
+        SampleRecorder  *recorder[DP700_MAX_CHANNELS];
+        SampleArchive   *archive[DP700_MAX_CHANNELS];
+        bool            setpointsSent;
+        qint64          samples;        // poll cycles
+    } DEVICE;
+
+    bool openSinks(const QStringList &names);
+    bool extract(const QString &fileName, qint64 from, qint64 to);
+    void writeSample(const SAMPLE &x, const QString &port = QString(), bool withChannel = false);
+    static bool parseTime(const QString &text, qint64 &ms);
+    static QString fileFor(const QString &fileName, const QString &port, int channel);
+
+    DeviceManager   *m_manager;
+    QVector<DEVICE> m_devices;          // same order as in m_manager
+    QList<QFile*>   m_sinks;
+    double          m_setVoltage;       // NaN: leave unchanged
+    double          m_setCurrent;
+    int             m_setOutput;        // -1: leave unchanged, 0: off, 1: on
+    int             m_channels;         // polled outputs
+    int             m_channel;          // output the setpoints are for
+    qint64          m_count;            // stop after that many samples per device, 0: run forever
+    qint64          m_samples;
+    bool            m_dumpStats;
+};
+
+#endif // HEADLESS_H
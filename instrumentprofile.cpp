@@ -0,0 +1,261 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// instrumentprofile.cpp
+// per model command set, number formats and ranges
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "instrumentprofile.h"
+#include <QSettings>
+#include <QFile>
+#include <QVector>
+#include <QDebug>
+
+// ---------------------------------------------------------------------------
+// built-in models
+
+struct DP711 {
+    static const char *name() { return "DP711"; }
+    enum { CHANNELS = 1, VOLTAGE_DECIMALS = 2, CURRENT_DECIMALS = 2, CHANNEL_QUERIES = false };
+    static const InstrumentProfile::BATCHING BATCHING = InstrumentProfile::BatchProbe;
+    static InstrumentProfile::RANGE range(int) { return { 0, 30, 5 }; }
+};
+
+struct DP712 {
+    static const char *name() { return "DP712"; }
+    enum { CHANNELS = 1, VOLTAGE_DECIMALS = 2, CURRENT_DECIMALS = 2, CHANNEL_QUERIES = false };
+    static const InstrumentProfile::BATCHING BATCHING = InstrumentProfile::BatchProbe;
+    static InstrumentProfile::RANGE range(int) { return { 0, 50, 3 }; }
+};
+
+struct DP821 {
+    static const char *name() { return "DP821"; }
+    enum { CHANNELS = 2, VOLTAGE_DECIMALS = 3, CURRENT_DECIMALS = 4, CHANNEL_QUERIES = true };
+    static const InstrumentProfile::BATCHING BATCHING = InstrumentProfile::BatchProbe;
+    static InstrumentProfile::RANGE range(int channel) { return (channel == 1) ? InstrumentProfile::RANGE{ 0, 60, 1 } : InstrumentProfile::RANGE{ 0, 8, 10 }; }
+};
+
+struct DP831 {
+    static const char *name() { return "DP831"; }
+    enum { CHANNELS = 3, VOLTAGE_DECIMALS = 3, CURRENT_DECIMALS = 4, CHANNEL_QUERIES = true };
+    static const InstrumentProfile::BATCHING BATCHING = InstrumentProfile::BatchProbe;
+    static InstrumentProfile::RANGE range(int channel)
+    {
+        switch (channel) {
+        case 1:  return { 0, 8, 5 };
+        case 2:  return { 0, 30, 2 };
+        default: return { -30, 0, 2 };
+        }
+    }
+};
+
+struct DP832 {
+    static const char *name() { return "DP832"; }
+    enum { CHANNELS = 3, VOLTAGE_DECIMALS = 3, CURRENT_DECIMALS = 3, CHANNEL_QUERIES = true };
+    static const InstrumentProfile::BATCHING BATCHING = InstrumentProfile::BatchProbe;
+    static InstrumentProfile::RANGE range(int channel) { return (channel == 3) ? InstrumentProfile::RANGE{ 0, 5, 3 } : InstrumentProfile::RANGE{ 0, 30, 3 }; }
+};
+
+// ---------------------------------------------------------------------------
+// user defined models, the commands are templates like ":APPL CH{ch},{v},{c}"
+
+class UserProfile : public InstrumentProfile
+{
+public:
+    typedef enum {
+        FieldNone,
+        FieldChannel,
+        FieldVoltage,
+        FieldCurrent,
+        FieldOnOff
+    } FIELD;
+
+    typedef struct {
+        QByteArray  text;           // written before the field
+        FIELD       field;
+    } PIECE;
+
+    static UserProfile *read(QSettings &ini, const QString &model);
+
+    int encodeSetpoints(char *buf, int channel, double v, double c) const override
+    {
+        return encode(m_apply, buf, channel, v, c, false);
+    }
+
+    int encodeOutput(char *buf, int channel, bool on) const override
+    {
+        return encode(m_output, buf, channel, 0, 0, on);
+    }
+
+private:
+    static bool parse(const QString &command, QVector<PIECE> &pieces);
+    int encode(const QVector<PIECE> &pieces, char *buf, int channel, double v, double c, bool on) const;
+
+    QVector<PIECE>  m_apply;
+    QVector<PIECE>  m_output;
+    quint64         m_voltageScale;
+    quint64         m_currentScale;
+};
+
+// longest number a field may produce: sign, 6 integer digits, point, decimals
+#define FIELD_SIZE(decimals)    (8 + (decimals))
+#define MAX_DECIMALS            6
+
+bool UserProfile::parse(const QString &command, QVector<PIECE> &pieces)
+{
+    static const struct {
+        const char  *name;
+        FIELD       field;
+    } fields[] = {
+        { "{ch}", FieldChannel }, { "{v}", FieldVoltage }, { "{c}", FieldCurrent }, { "{on}", FieldOnOff }
+    };
+    QByteArray s = command.toLatin1();
+    pieces.clear();
+    int start = 0;
+    forever {
+        int pos = s.indexOf('{', start);
+        PIECE piece;
+        piece.field = FieldNone;
+        if (pos < 0) {
+            piece.text = s.mid(start) + '\n';
+            pieces.append(piece);
+            return true;
+        }
+        for (const auto &f : fields) {
+            if (s.mid(pos, int(strlen(f.name))) == f.name) {
+                piece.field = f.field;
+                piece.text = s.mid(start, pos - start);
+                start = pos + int(strlen(f.name));
+                break;
+            }
+        }
+        if (piece.field == FieldNone)
+            return false;
+        pieces.append(piece);
+    }
+}
+
+UserProfile *UserProfile::read(QSettings &ini, const QString &model)
+{
+    UserProfile *p = new UserProfile;
+    p->m_model = model;
+    ini.beginGroup(model);
+    p->m_channels = ini.value("channels", 1).toInt();
+    p->m_voltageDecimals = ini.value("voltageDecimals", 2).toInt();
+    p->m_currentDecimals = ini.value("currentDecimals", 3).toInt();
+    QString batching = ini.value("batching", "probe").toString();
+    p->m_batching = (batching == "always") ? BatchAlways : (batching == "never") ? BatchNever : BatchProbe;
+    p->m_channelQueries = ini.value("channelQueries", p->m_channels > 1).toBool();
+    // one value per channel, the last one is used for the remaining channels
+    QStringList minVoltage = ini.value("minVoltage", "0").toStringList();
+    QStringList maxVoltage = ini.value("maxVoltage").toStringList();
+    QStringList maxCurrent = ini.value("maxCurrent").toStringList();
+    bool ok = parse(ini.value("apply", ":APPL CH{ch},{v},{c}").toString(), p->m_apply)
+            && parse(ini.value("output", ":OUTP:STAT CH{ch},{on}").toString(), p->m_output);
+    ini.endGroup();
+
+    ok = ok && (p->m_channels >= 1) && (p->m_channels <= DP700_MAX_CHANNELS)
+            && (p->m_voltageDecimals >= 0) && (p->m_voltageDecimals <= MAX_DECIMALS)
+            && (p->m_currentDecimals >= 0) && (p->m_currentDecimals <= MAX_DECIMALS)
+            && !maxVoltage.isEmpty() && !maxCurrent.isEmpty();
+    for (int ch=0; ok && (ch<p->m_channels); ++ch) {
+        RANGE &r = p->m_range[ch];
+        r.minVoltage = minVoltage.at(qMin(ch, minVoltage.size()-1)).toDouble();
+        r.maxVoltage = maxVoltage.at(qMin(ch, maxVoltage.size()-1)).toDouble();
+        r.maxCurrent = maxCurrent.at(qMin(ch, maxCurrent.size()-1)).toDouble();
+        ok = (r.minVoltage < r.maxVoltage) && (r.maxCurrent > 0) && (qAbs(r.minVoltage) < 1e6) && (r.maxVoltage < 1e6);
+    }
+    // the encoded commands must fit into PROFILE_COMMAND_SIZE
+    for (const QVector<PIECE> *pieces : { &p->m_apply, &p->m_output }) {
+        int size = 0;
+        for (const PIECE &piece : *pieces)
+            size += piece.text.size() + FIELD_SIZE(qMax(p->m_voltageDecimals, p->m_currentDecimals));
+        ok = ok && (size <= PROFILE_COMMAND_SIZE);
+    }
+    if (!ok) {
+        qWarning() << "invalid instrument profile" << model;
+        delete p;
+        return nullptr;
+    }
+    p->m_voltageScale = 1;
+    for (int i=0; i<p->m_voltageDecimals; ++i)
+        p->m_voltageScale *= 10;
+    p->m_currentScale = 1;
+    for (int i=0; i<p->m_currentDecimals; ++i)
+        p->m_currentScale *= 10;
+    return p;
+}
+
+int UserProfile::encode(const QVector<PIECE> &pieces, char *buf, int channel, double v, double c, bool on) const
+{
+    char *p = buf;
+    for (const PIECE &piece : pieces) {
+        p = ScpiEncode::text(p, piece.text);
+        switch (piece.field) {
+        case FieldNone:     break;
+        case FieldChannel:  p = ScpiEncode::number(p, quint64(channel)); break;
+        case FieldVoltage:  p = ScpiEncode::fixed(p, v, m_voltageDecimals, m_voltageScale); break;
+        case FieldCurrent:  p = ScpiEncode::fixed(p, c, m_currentDecimals, m_currentScale); break;
+        case FieldOnOff:    p = ScpiEncode::text(p, on ? "ON" : "OFF"); break;
+        }
+    }
+    return int(p - buf);
+}
+
+// ---------------------------------------------------------------------------
+// registry, filled before any device is created
+
+static QList<const InstrumentProfile *> &profiles()
+{
+    static const TBuiltinProfile<DP711> dp711;
+    static const TBuiltinProfile<DP712> dp712;
+    static const TBuiltinProfile<DP821> dp821;
+    static const TBuiltinProfile<DP831> dp831;
+    static const TBuiltinProfile<DP832> dp832;
+    static QList<const InstrumentProfile *> list = { &dp711, &dp712, &dp821, &dp831, &dp832 };
+    return list;
+}
+
+const InstrumentProfile *InstrumentProfile::find(const QString &model)
+{
+    for (const InstrumentProfile *p : profiles()) {
+        if (p->model().compare(model, Qt::CaseInsensitive) == 0)
+            return p;
+    }
+    return nullptr;
+}
+
+QStringList InstrumentProfile::models()
+{
+    QStringList names;
+    for (const InstrumentProfile *p : profiles())
+        names << p->model();
+    return names;
+}
+
+int InstrumentProfile::load(const QString &fileName)
+{
+    if (!QFile::exists(fileName)) {
+        qWarning() << "instrument profiles" << fileName << "not found";
+        return -1;
+    }
+    QSettings ini(fileName, QSettings::IniFormat);
+    int count = 0;
+    for (const QString &model : ini.childGroups()) {
+        UserProfile *p = UserProfile::read(ini, model);
+        if (!p)
+            return -1;
+        // a user defined model replaces a built-in one of the same name, profiles are never freed
+        const InstrumentProfile *old = find(model);
+        if (old)
+            profiles().removeOne(old);
+        profiles().append(p);
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,186 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// instrumentprofile.h
+// per model command set, number formats and ranges, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef INSTRUMENTPROFILE_H
+#define INSTRUMENTPROFILE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <cstring>
+
+// outputs of the largest supported instruments, e.g. DP800 series
+#define DP700_MAX_CHANNELS  3
+// longest set command including the terminating '\n'
+#define PROFILE_COMMAND_SIZE 64
+
+// A profile tells how to talk to one instrument model. Built-in models are
+// TBuiltinProfile<MODEL> instances whose number formats and command pieces
+// are compile time constants; user defined models come from an INI file and
+// are encoded from the same pieces kept at runtime. Set commands are encoded
+// straight into a caller supplied buffer, no string is built on the way.
+class InstrumentProfile
+{
+public:
+    typedef enum {
+        BatchProbe,         // try compound queries, fall back if they fail
+        BatchAlways,
+        BatchNever
+    } BATCHING;
+
+    typedef struct {
+        double  minVoltage;
+        double  maxVoltage;
+        double  maxCurrent;
+    } RANGE;
+
+    virtual ~InstrumentProfile() {}
+
+    const QString &model() const { return m_model; }
+    int channels() const { return m_channels; }
+    // channels count from 1
+    const RANGE &range(int channel) const { return m_range[channel-1]; }
+    int voltageDecimals() const { return m_voltageDecimals; }
+    int currentDecimals() const { return m_currentDecimals; }
+    BATCHING batching() const { return m_batching; }
+    // queries name the channel, e.g. ":MEAS:ALL? CH2"
+    bool channelQueries() const { return m_channelQueries; }
+
+    // fill buf (PROFILE_COMMAND_SIZE bytes) with the complete command, return its length
+    virtual int encodeSetpoints(char *buf, int channel, double v, double c) const = 0;
+    virtual int encodeOutput(char *buf, int channel, bool on) const = 0;
+
+    // built-in and loaded models, nullptr if unknown
+    static const InstrumentProfile *find(const QString &model);
+    static QStringList models();
+    // adds the models defined in an INI file, returns how many, -1 on errors
+    static int load(const QString &fileName);
+
+protected:
+    QString     m_model;
+    int         m_channels;
+    RANGE       m_range[DP700_MAX_CHANNELS];
+    int         m_voltageDecimals;
+    int         m_currentDecimals;
+    BATCHING    m_batching;
+    bool        m_channelQueries;
+};
+
+// ---------------------------------------------------------------------------
+// encoding helpers, each returns the position behind what it has written
+
+namespace ScpiEncode {
+
+inline char *text(char *p, const char *s)
+{
+    while (*s)
+        *p++ = *s++;
+    return p;
+}
+
+inline char *text(char *p, const QByteArray &s)
+{
+    memcpy(p, s.constData(), size_t(s.size()));
+    return p + s.size();
+}
+
+inline char *number(char *p, quint64 x)
+{
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + x % 10);
+        x /= 10;
+    } while (x);
+    while (n)
+        *p++ = digits[--n];
+    return p;
+}
+
+// fixed point with a runtime number of decimals
+inline char *fixed(char *p, double x, int decimals, quint64 scale)
+{
+    if (x < 0) {
+        *p++ = '-';
+        x = -x;
+    }
+    quint64 q = quint64(x * scale + 0.5);
+    p = number(p, q / scale);
+    if (decimals > 0) {
+        *p++ = '.';
+        quint64 f = q % scale;
+        for (int i=decimals-1; i>=0; --i) {
+            p[i] = char('0' + f % 10);
+            f /= 10;
+        }
+        p += decimals;
+    }
+    return p;
+}
+
+template <int DECIMALS>
+struct Pow10 { static const quint64 value = 10 * Pow10<DECIMALS-1>::value; };
+template <>
+struct Pow10<0> { static const quint64 value = 1; };
+
+// fixed point with a compile time number of decimals
+template <int DECIMALS>
+inline char *fixed(char *p, double x)
+{
+    return fixed(p, x, DECIMALS, Pow10<DECIMALS>::value);
+}
+
+} // namespace ScpiEncode
+
+// ---------------------------------------------------------------------------
+// MODEL provides, as compile time constants:
+//   name(), CHANNELS, VOLTAGE_DECIMALS, CURRENT_DECIMALS, BATCHING,
+//   CHANNEL_QUERIES and range(channel) for every channel
+template <typename MODEL>
+class TBuiltinProfile : public InstrumentProfile
+{
+public:
+    TBuiltinProfile()
+    {
+        Q_STATIC_ASSERT(MODEL::CHANNELS >= 1 && MODEL::CHANNELS <= DP700_MAX_CHANNELS);
+        m_model = MODEL::name();
+        m_channels = MODEL::CHANNELS;
+        for (int ch=1; ch<=MODEL::CHANNELS; ++ch)
+            m_range[ch-1] = MODEL::range(ch);
+        m_voltageDecimals = MODEL::VOLTAGE_DECIMALS;
+        m_currentDecimals = MODEL::CURRENT_DECIMALS;
+        m_batching = MODEL::BATCHING;
+        m_channelQueries = MODEL::CHANNEL_QUERIES;
+    }
+
+    int encodeSetpoints(char *buf, int channel, double v, double c) const override
+    {
+        char *p = ScpiEncode::text(buf, ":APPL CH");
+        p = ScpiEncode::number(p, quint64(channel));
+        *p++ = ',';
+        p = ScpiEncode::fixed<MODEL::VOLTAGE_DECIMALS>(p, v);
+        *p++ = ',';
+        p = ScpiEncode::fixed<MODEL::CURRENT_DECIMALS>(p, c);
+        *p++ = '\n';
+        return int(p - buf);
+    }
+
+    int encodeOutput(char *buf, int channel, bool on) const override
+    {
+        char *p = ScpiEncode::text(buf, ":OUTP:STAT CH");
+        p = ScpiEncode::number(p, quint64(channel));
+        p = ScpiEncode::text(p, on ? ",ON\n" : ",OFF\n");
+        return int(p - buf);
+    }
+};
+
+#endif // INSTRUMENTPROFILE_H
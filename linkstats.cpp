@@ -0,0 +1,115 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// linkstats.cpp
+// round trip latency histograms and link throughput
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "linkstats.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+LinkStats::LinkStats(int types)
+    : m_hist(types)
+{
+    reset();
+}
+
+void LinkStats::reset()
+{
+    for (HISTOGRAM &h : m_hist)
+        memset(&h, 0, sizeof(h));
+    m_timeouts = 0;
+    m_cycles = 0;
+    m_lastNs = -1;
+    m_lastCycles = 0;
+    m_lastRxBytes = 0;
+    m_lastTxBytes = 0;
+}
+
+void LinkStats::addLatency(int type, qint64 ns)
+{
+    if ((type < 0) || (type >= m_hist.size()))
+        return;
+    qint64 us = qMax(Q_INT64_C(0), ns / 1000);
+    HISTOGRAM &h = m_hist[type];
+    ++h.bucket[bucketOf(us)];
+    ++h.count;
+    if (us > h.maxUs)
+        h.maxUs = us;
+}
+
+LinkStats::LATENCY LinkStats::latency(int type) const
+{
+    LATENCY l;
+    memset(&l, 0, sizeof(l));
+    if ((type >= 0) && (type < m_hist.size())) {
+        const HISTOGRAM &h = m_hist.at(type);
+        l.count = h.count;
+        if (h.count) {
+            l.p50 = qMin(percentile(h, 0.50), double(h.maxUs)) / 1000.0;
+            l.p95 = qMin(percentile(h, 0.95), double(h.maxUs)) / 1000.0;
+            l.p99 = qMin(percentile(h, 0.99), double(h.maxUs)) / 1000.0;
+            l.max = h.maxUs / 1000.0;
+        }
+    }
+    return l;
+}
+
+LinkStats::RATES LinkStats::rates(qint64 nowNs, quint64 rxBytes, quint64 txBytes)
+{
+    RATES r;
+    memset(&r, 0, sizeof(r));
+    if ((m_lastNs >= 0) && (nowNs > m_lastNs)) {
+        double dT = (nowNs - m_lastNs) / 1e9;
+        r.cyclesPerSecond = (m_cycles - m_lastCycles) / dT;
+        r.rxBytesPerSecond = (rxBytes - m_lastRxBytes) / dT;
+        r.txBytesPerSecond = (txBytes - m_lastTxBytes) / dT;
+    }
+    m_lastNs = nowNs;
+    m_lastCycles = m_cycles;
+    m_lastRxBytes = rxBytes;
+    m_lastTxBytes = txBytes;
+    return r;
+}
+
+int LinkStats::bucketOf(qint64 us)
+{
+    // values below 8 us get a bucket each, above that 8 buckets per power of two
+    if (us < LATENCY_SUB_BUCKETS)
+        return int(us);
+    int e = 63 - int(qCountLeadingZeroBits(quint64(us)));
+    if (e >= LATENCY_MAX_EXPONENT)
+        return LATENCY_BUCKETS - 1;
+    int sub = int(us >> (e - 3)) & (LATENCY_SUB_BUCKETS - 1);
+    return (e - 2) * LATENCY_SUB_BUCKETS + sub;
+}
+
+qint64 LinkStats::bucketLimit(int bucket)
+{
+    // first value of the next bucket
+    if (bucket < LATENCY_SUB_BUCKETS)
+        return bucket + 1;
+    int e = bucket / LATENCY_SUB_BUCKETS + 2;
+    int sub = bucket % LATENCY_SUB_BUCKETS;
+    return qint64(LATENCY_SUB_BUCKETS + sub + 1) << (e - 3);
+}
+
+double LinkStats::percentile(const HISTOGRAM &h, double p)
+{
+    quint64 rank = quint64(p * h.count);
+    if (rank >= h.count)
+        rank = h.count - 1;
+    quint64 sum = 0;
+    for (int i=0; i<LATENCY_BUCKETS; ++i) {
+        sum += h.bucket[i];
+        if (sum > rank)
+            return double(bucketLimit(i));
+    }
+    return double(h.maxUs);
+}
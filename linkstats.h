@@ -0,0 +1,74 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// linkstats.h
+// round trip latency histograms and link throughput, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef LINKSTATS_H
+#define LINKSTATS_H
+
+#include <QtGlobal>
+#include <QVector>
+
+// log-linear histogram: 8 buckets per power of two, about 12 % resolution
+#define LATENCY_SUB_BUCKETS     8
+#define LATENCY_MAX_EXPONENT    36      // 2^36 us, longer latencies end up in the last bucket
+#define LATENCY_BUCKETS         ((LATENCY_MAX_EXPONENT - 2) * LATENCY_SUB_BUCKETS)
+
+class LinkStats
+{
+public:
+    typedef struct {
+        quint64 count;
+        double  p50;        // all latencies in milliseconds
+        double  p95;
+        double  p99;
+        double  max;
+    } LATENCY;
+
+    typedef struct {
+        double  cyclesPerSecond;
+        double  rxBytesPerSecond;
+        double  txBytesPerSecond;
+    } RATES;
+
+    explicit LinkStats(int types);
+
+    void reset();
+    void addLatency(int type, qint64 ns);
+    void addTimeout() { ++m_timeouts; }
+    void addCycle() { ++m_cycles; }
+
+    LATENCY latency(int type) const;
+    quint64 timeouts() const { return m_timeouts; }
+    // average rates since the previous call, byte counters are totals
+    RATES rates(qint64 nowNs, quint64 rxBytes, quint64 txBytes);
+
+private:
+    typedef struct {
+        quint32 bucket[LATENCY_BUCKETS];
+        quint64 count;
+        qint64  maxUs;
+    } HISTOGRAM;
+
+    static int bucketOf(qint64 us);
+    static qint64 bucketLimit(int bucket);
+    static double percentile(const HISTOGRAM &h, double p);
+
+    QVector<HISTOGRAM>  m_hist;
+    quint64             m_timeouts;
+    quint64             m_cycles;
+    // state of the previous rates() call
+    qint64              m_lastNs;
+    quint64             m_lastCycles;
+    quint64             m_lastRxBytes;
+    quint64             m_lastTxBytes;
+};
+
+#endif // LINKSTATS_H
@@ -12,10 +12,43 @@
 // ***************************************************************************
 #include "mainwidget.h"
 #include "tapp.h"
+#include "headless.h"
+#include "deviceview.h"
+#include "dp700.h"
+#include "tlogrecord.h"
+#include <QSettings>
+
+#define GRP_DP700           "DP700_Config"
+#define CFG_LOG_RULES       "logRules"
 
 int main(int argc, char *argv[])
 {
+    if (Headless::isRequested(argc, argv)) {
+        // acquisition only: no QApplication, no widgets, no fonts
+        QCoreApplication a(argc, argv);
+        a.setOrganizationName(APP_ORGANIZATION);
+        a.setOrganizationDomain(APP_DOMAIN);
+        a.setApplicationName(APP_NAME);
+        a.setApplicationVersion(APP_VERSION);
+        Headless h;
+        if (!h.start(a.arguments()))
+            return 1;
+        return a.exec();
+    }
     TApp a(argc, argv);
+    // the same logging rules for every window, before any device is created
+    QSettings cfg;
+    cfg.beginGroup(GRP_DP700);
+    // logging category rules separated by ';', e.g. "dp700.scpi.debug=true"
+    tSetLogRules(QString(DP700_LOG_RULES) + ';' + cfg.value(CFG_LOG_RULES).toString());
+    cfg.endGroup();
+    QStringList ports = DeviceView::requestedPorts(a.arguments());
+    if (!ports.isEmpty()) {
+        // many instruments in one compact view
+        DeviceView v(ports);
+        v.show();
+        return a.exec();
+    }
     MainWidget w;
     w.show();
     return a.exec();
@@ -23,27 +23,52 @@
 #include <QMessageBox>
 #include <QSettings>
 #include "dp700.h"
-#include <QSerialPortInfo>
+#include "pollscheduler.h"
+#include "samplerecorder.h"
+#include "trendplot.h"
+#include "portwatcher.h"
+#include <QThread>
+#include <QFileDialog>
+#include <QScrollBar>
+
+static Q_LOGGING_CATEGORY(lcPoll, "dp700.poll")
 
-#define InfoFlags (IdentificationReceived | VersionReceived)
 #define UpdateFlags (MeasuredVoltageReceived | MeasuredCurrentReceived | MeasuredPowerReceived | SetVoltageReceived | SetCurrentReceived | OnOffReceived | ErrorReceived )
 
 #define GRP_DP700           "DP700_Config"
 #define CFG_ALWAYS_ON_TOP   "alwaysOnTop"
 #define CFG_LOG_FONT_SIZE   "logFont"
+#define CFG_LOG_MAX_LINES   "logMaxLines"
+#define CFG_MAX_POLL_RATE   "maxPollRate"
+#define CFG_RECORDING       "recording"
+#define CFG_MODEL           "model"
+#define CFG_PROFILES        "profiles"
+#define CFG_CHANNEL         "channel"
+#define CFG_LIVE_SETPOINTS  "liveSetpoints"
+#define CFG_MAX_SET_RATE    "maxSetRate"
 
 #define CFG_SERIALPORT      "SerialPort"
-// expect a successful new measurement at least every second
+#define CFG_BAUDRATE        "BaudRate"
+#define CFG_DETECTED_BAUDRATE "DetectedBaudRate"
+// expect a successful new measurement at least every second; while polling, stalls are
+// recovered by the device itself and the watchdog only shows them
 #define WATCHDOG_MS 2000
+// a present port that failed to open is tried again that often, e.g. while another program holds it
+#define REOPEN_MS 5000
+// render new log lines at most that often
+#define LOG_FLUSH_MS 40
+// ignore stale readback of setpoints for that many poll cycles after a set command
+#define SET_HOLD_CYCLES 3
 
 MainWidget::MainWidget(QWidget *parent)
     : TMainWidget(parent)
     , ui(new Ui::MainWidget)
-    , m_lastCommandErrorRequest(false)
     , m_dev(nullptr)
     , m_flags(0)
-    , m_idUpdateTimer(0)
+    , m_scheduler(nullptr)
+    , m_polling(false)
     , m_idWatchdogTimer(0)
+    , m_idReopenTimer(0)
     , m_setOnOff(false)
     , m_setVA(false)
     , m_setVoltageChanged(false)
@@ -51,6 +76,23 @@ MainWidget::MainWidget(QWidget *parent)
     , m_indicatorCount(0)
     , m_indicatorInc(8)
     , m_port("COM17")
+    , m_baudRate(0)
+    , m_detectedBaudRate(9600)
+    , m_maxPollRate(0)
+    , m_holdOnOff(0)
+    , m_holdVA(0)
+    , m_retryOnOff(false)
+    , m_retryVA(false)
+    , m_profile(nullptr)
+    , m_channel(1)
+    , m_maxSetRate(10)
+    , m_ioThread(new QThread(this))
+    , m_ioContext(new QObject)
+    , m_portThread(new QThread(this))
+    , m_portWatcher(new PortWatcher)
+    , m_recorder(nullptr)
+    , m_logFlushTimer(new QTimer(this))
+    , m_logMaxLines(5000)
 {
     ui->setupUi(this);
     QSettings cfg;
@@ -60,10 +102,47 @@ MainWidget::MainWidget(QWidget *parent)
     QFont f = ui->textMessage->document()->defaultFont();
     f.setPointSizeF(cfg.value(CFG_LOG_FONT_SIZE, f.pointSizeF()).toReal());
     ui->textMessage->document()->setDefaultFont(f);
+    // the view drops the oldest lines itself
+    m_logMaxLines = qMax(100, cfg.value(CFG_LOG_MAX_LINES, m_logMaxLines).toInt());
+    ui->textMessage->setMaximumBlockCount(m_logMaxLines);
+    m_maxPollRate = cfg.value(CFG_MAX_POLL_RATE, m_maxPollRate).toDouble();
+    // user defined models from an INI file, see README.md
+    if (cfg.contains(CFG_PROFILES))
+        InstrumentProfile::load(cfg.value(CFG_PROFILES).toString());
+    QString model = cfg.value(CFG_MODEL, "DP712").toString();
+    m_profile = InstrumentProfile::find(model);
+    if (!m_profile) {
+        qWarning() << "unknown instrument model" << model << "- known are" << InstrumentProfile::models().join(", ");
+        m_profile = InstrumentProfile::find("DP712");
+    }
+    // multi output instruments: all outputs are polled, one of them is shown
+    m_channel = qBound(1, cfg.value(CFG_CHANNEL, m_channel).toInt(), m_profile->channels());
+    SilentCall(ui->maxPollRate)->setValue(m_maxPollRate);
+    SilentCall(ui->liveSetpoints)->setChecked(cfg.value(CFG_LIVE_SETPOINTS, false).toBool());
+    m_maxSetRate = cfg.value(CFG_MAX_SET_RATE, m_maxSetRate).toDouble();
     cfg.endGroup();
 
+    // text formats for tag and text of each message type
+    static const struct {
+        const char *tag;
+        const char *text;
+    } logColors[LOG_LEVELS] = {
+        { "grey", "black" },                // LogInfo
+        { "royalblue", "mediumblue" },      // LogWarning
+        { "indianred", "firebrick" },       // LogCritical
+        { "blueviolet", "darkviolet" },     // LogFatal
+        { "darkgray", "gray" },             // LogOther
+    };
+    for (int i=0; i<LOG_LEVELS; ++i) {
+        m_logFormats[i][0].setForeground(QColor(logColors[i].tag));
+        m_logFormats[i][1].setForeground(QColor(logColors[i].text));
+    }
+    m_logFlushTimer->setSingleShot(true);
+    m_logFlushTimer->setInterval(LOG_FLUSH_MS);
+    connect(m_logFlushTimer, &QTimer::timeout, this, &MainWidget::flushLog);
+
     // allow debug message display
-    connect(reinterpret_cast<TApp*>(qApp)->msgHandler(), SIGNAL(messageAdded(QString)), this, SLOT(on_messageAdded(QString)));
+    connect(reinterpret_cast<TApp*>(qApp)->msgHandler(), SIGNAL(messageAdded(TLOG_RECORD)), this, SLOT(on_messageAdded(TLOG_RECORD)));
 
     // handle power events
     connect(this, &MainWidget::ResumeSuspend, this, &MainWidget::onResume);
@@ -83,44 +162,139 @@ MainWidget::MainWidget(QWidget *parent)
     ui->setAmps->setFont(fontLCDsmall);
     ui->setVolts->setStyleSheet("color:white;");
     ui->setAmps->setStyleSheet("color:white;");
+    // the setpoints can not leave the ratings of the shown output
+    const InstrumentProfile::RANGE &range = m_profile->range(m_channel);
+    SilentCall(ui->setVolts)->setDecimals(m_profile->voltageDecimals());
+    SilentCall(ui->setVolts)->setRange(range.minVoltage, range.maxVoltage);
+    SilentCall(ui->setAmps)->setDecimals(m_profile->currentDecimals());
+    SilentCall(ui->setAmps)->setRange(0, range.maxCurrent);
 
     m_port = cfg.value(CFG_SERIALPORT, m_port).toString();
     qDebug() << "last serial port:" << m_port;
-    // detect serial ports and fill combo box
-    qDebug() << "detected COM Ports:";
-    QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
-    int inx=0;
-    for (auto &port : ports) {
-        QString name = port.portName();
-        qDebug() << "    " << inx << ": "<< name;
-        SilentCall(ui->serialPort)->addItem(name);
-        if (m_port == name) {
-            m_serialPortIndex = inx;
-            qDebug() << "           -> that's it!";
-        }
-        ++inx;
-    }
-    if (m_serialPortIndex>=0) {
-        SilentCall(ui->serialPort)->setCurrentText(ui->serialPort->itemText(m_serialPortIndex));
-    }
+    // the other ports are filled in when they are detected, that may take a while
+    SilentCall(ui->serialPort)->addItem(m_port);
+    m_serialPortIndex = 0;
+
+    // baud rate selection, auto detection probes all supported rates
+    m_baudRate = cfg.value(CFG_BAUDRATE, m_baudRate).toUInt();
+    m_detectedBaudRate = cfg.value(CFG_DETECTED_BAUDRATE, m_detectedBaudRate).toUInt();
+    qDebug() << "baud rate:" << m_baudRate << "last detected:" << m_detectedBaudRate;
+    SilentCall(ui->baudRate)->addItem(tr("auto"), 0);
+    for (quint32 rate : DP700::supportedBaudRates())
+        SilentCall(ui->baudRate)->addItem(QString::number(rate), rate);
+    SilentCall(ui->baudRate)->setCurrentIndex(qMax(0, ui->baudRate->findData(m_baudRate)));
+
+    // all serial communication runs in its own thread, independent of the GUI
+    m_ioThread->setObjectName("DP700 I/O");
+    m_ioContext->moveToThread(m_ioThread);
+    m_ioThread->start();
+
+    // port enumeration and hotplug events are handled in a thread of their own
+    m_portThread->setObjectName("serial port watcher");
+    m_portWatcher->moveToThread(m_portThread);
+    connect(m_portThread, &QThread::finished, m_portWatcher, &QObject::deleteLater);
+    connect(m_portWatcher, &PortWatcher::portsChanged, this, &MainWidget::setSerialPorts);
+    connect(m_portWatcher, &PortWatcher::portAdded, this, &MainWidget::onPortAdded);
+    connect(m_portWatcher, &PortWatcher::portRemoved, this, &MainWidget::onPortRemoved);
+    m_portThread->start();
+    QMetaObject::invokeMethod(m_portWatcher, "start", Qt::QueuedConnection);
 
     reconnectDevice(m_port);
 }
 
-void MainWidget::startDevice()
+void MainWidget::setSerialPorts(const QStringList &ports)
 {
+    qDebug() << "detected serial ports:" << ports.join(", ");
+    m_serialPorts = ports;
+    // the configured port stays selectable while it is missing
+    QStringList items = ports;
+    if (!items.contains(m_port))
+        items.prepend(m_port);
+    ui->serialPort->blockSignals(true);
+    ui->serialPort->clear();
+    ui->serialPort->addItems(items);
+    m_serialPortIndex = items.indexOf(m_port);
+    ui->serialPort->setCurrentIndex(m_serialPortIndex);
+    ui->serialPort->blockSignals(false);
+}
+
+void MainWidget::onPortAdded(const QString &port)
+{
+    // the adapter is back, no need to wait for the watchdog
+    if ((port == m_port) && !m_dev) {
+        qInfo() << "serial port" << port << "is available again";
+        reconnectDevice(m_port);
+    }
+}
+
+void MainWidget::onPortRemoved(const QString &port)
+{
+    if ((port == m_port) && m_dev) {
+        qWarning() << "serial port" << port << "removed";
+        disconnectDevice();
+        updateIndicator(false);
+    }
+}
+
+void MainWidget::startDevice(bool ok)
+{
+    // ignore late notifications of an already replaced device
+    if (sender() != m_dev)
+        return;
     // check if device is available
-    if ((m_dev!=nullptr) && (!m_dev->isValid())) {
-        QMessageBox::critical(this, qApp->applicationDisplayName(), tr("No device or cannot open serial port"));
-        qCritical() << "No device or cannot open serial port";
-        close();
+    if (!ok) {
+        // connected again as soon as the port watcher sees the port, or a little later if it is
+        // there already: a quick unplug and replug does not change the port list
+        qCritical() << "No device or cannot open serial port" << m_port;
+        disconnectDevice();
+        updateIndicator(false);
+        m_idReopenTimer = startTimer(REOPEN_MS);
+        return;
+    }
+    if (m_baudRate == 0) {
+        // find the instrument's baud rate first, polling starts when it is known
+        QMetaObject::invokeMethod(m_dev, "detectBaudRate", Qt::QueuedConnection, Q_ARG(quint32, m_detectedBaudRate));
+        return;
     }
-    // start regular operations
-    m_idUpdateTimer = startTimer(20, Qt::PreciseTimer);
+    startPolling();
+}
+
+void MainWidget::startPolling()
+{
+    // start regular operations, the identification is queued ahead of the first cycle
+    m_dev->queryInfo();
+    QMetaObject::invokeMethod(m_scheduler, "start", Qt::QueuedConnection);
+    m_polling = true;
     triggerWatchdog();
     // prevent uncontrolled power down
 }
 
+void MainWidget::onBaudRateDetected(quint32 baudrate)
+{
+    m_detectedBaudRate = baudrate;
+    QSettings cfg;
+    cfg.setValue(CFG_DETECTED_BAUDRATE, m_detectedBaudRate);
+    startPolling();
+}
+
+void MainWidget::onPortError(const QString &text)
+{
+    // ignore late notifications of an already replaced device
+    if (sender() != m_dev)
+        return;
+    qCritical() << "serial port error:" << text;
+    updateIndicator(false);
+    // an unplugged adapter fails to open and is connected again when it reappears
+    reconnectDevice(m_port);
+}
+
+void MainWidget::onBaudRateDetectionFailed()
+{
+    // let the watchdog reconnect and start over
+    updateIndicator(false);
+    triggerWatchdog();
+}
+
 MainWidget::~MainWidget()
 {
     qDebug() << "MainWidget::~MainWidget()";
@@ -130,159 +304,154 @@ MainWidget::~MainWidget()
     qreal s = ui->textMessage->document()->defaultFont().pointSizeF();
     cfg.setValue(CFG_LOG_FONT_SIZE, s);
     cfg.endGroup();
-    delete m_dev;
+    disconnectDevice();
+    stopRecording();
+    m_ioThread->quit();
+    m_ioThread->wait();
+    m_portThread->quit();
+    m_portThread->wait();
+    delete m_ioContext;
     delete ui;
 }
 
 void MainWidget::timerEvent(QTimerEvent *event)
 {
-    if (event->timerId() == m_idUpdateTimer) {
-//        qDebug() << "+++ MainWidget::timerEvent() +++";
-//        qDebug() << "      flags =" << Qt::hex << m_flags;
-        if ((m_flags & InfoFlags) != InfoFlags) {
-            //qDebug() << "      -> query info";
-            m_dev->queryInfo();
-        } else {
-            if ((m_flags & UpdateFlags) == 0) {
-                m_dev->measureAll();
-                qDebug() << "      -> measure all";
-            } else {
-                if (m_setOnOff) {
-                    qDebug() << "      -> set on/off to" << (m_newOnOff ? "ON" : "OFF");
-                    m_setOnOff = !m_dev->setOnOff(m_newOnOff);
-                } else if (m_setVA) {
-                    qDebug() << "      -> set voltage to" << m_newVoltage << "V, current to" << m_newCurrent << "A";
-                    m_setVA = !m_dev->setVoltageCurrent(m_newVoltage, m_newCurrent);
-                    if (!m_setVA) {
-                        m_setVoltageChanged = false;
-                        m_setCurrentChanged = false;
-                        ui->setVolts->setStyleSheet("color:white;");
-                        ui->setAmps->setStyleSheet("color:white;");
-                    }
-                } else {
-                    qDebug() << " start new measurement";
-                    m_flags &= ~UpdateFlags;
-                    updateIndicator(true);
-                    triggerWatchdog();
-                }
-            }
-        }
-//        qDebug() << "--- MainWidget::timerEvent() ---";
+    if (event->timerId() == m_idReopenTimer) {
+        killTimer(m_idReopenTimer);
+        m_idReopenTimer = 0;
+        // a missing port is reopened by onPortAdded()
+        if (!m_dev && m_serialPorts.contains(m_port))
+            reconnectDevice(m_port);
     } else if (event->timerId() == m_idWatchdogTimer) {
         if (m_flags) {
             qWarning() << "Watchdog Timeout!";
         }
         updateIndicator(false);
-        reconnectDevice(m_port);
+        // the port is reopened on port errors only, or if polling never started
+        if (!m_polling)
+            reconnectDevice(m_port);
+    }
+}
+
+void MainWidget::onCycleComplete()
+{
+    if ((m_flags & UpdateFlags) == UpdateFlags) {
+        updateIndicator(true);
+        triggerWatchdog();
     }
+    m_flags &= ~UpdateFlags;
+    // commands that did not fit into the queue are tried again once a cycle is done
+    if (m_retryOnOff && m_dev)
+        m_retryOnOff = !m_dev->setOnOff(m_newOnOff, m_channel);
+    if (m_retryVA && m_dev)
+        m_retryVA = !m_dev->setVoltageCurrent(m_newVoltage, m_newCurrent, m_channel);
+    // cycles queued before a set command still report the old state
+    if (m_setOnOff && !m_retryOnOff && (--m_holdOnOff <= 0))
+        m_setOnOff = false;
+    if (m_setVA && !m_retryVA && (--m_holdVA <= 0))
+        m_setVA = false;
 }
 
-void MainWidget::on_messageAdded(const QString &msg)
+void MainWidget::setPollRate(double x)
 {
-    QTextCursor cursor = ui->textMessage->cursorForPosition(QPoint(0,1));
-    QStringList sl = msg.split(']');
-    QString lineTag = sl.takeFirst() + "]";
-    QString lineText;
-    while (!sl.isEmpty())
-        lineText += sl.takeFirst();
-    bool bold =  lineText.contains("send:");
-    bool italics = lineText.contains("GUI:", Qt::CaseInsensitive);
-    QString lineColor, tagColor;
+    ui->pollRate->setText(tr("%1 /s").arg(x, 0, 'f', 1));
+}
 
-    // format qDebug() generated lines
-    if (lineText.contains("DBUG")) {
+void MainWidget::on_messageAdded(const TLOG_RECORD &msg)
+{
+    LOG_LINE line;
+    switch (msg.type) {
+    case QtDebugMsg:
         // do not add debug lines
         return;
-    } else if (lineText.contains("INFO")) {
-    // format qInfo() generated lines
-        tagColor = bold ? "black" : "grey";
-        lineColor = "black";
-        if (lineText.contains("\'BE\'")) {
-            if (bold) {
-                m_lastCommandErrorRequest = true;
-            } else {
-                if (!m_lastCommandErrorRequest) {
-                    tagColor = "chocolate";
-                    lineColor = "chocolate";
-                }
-                m_lastCommandErrorRequest = false;
-            }
-        } else if (lineText.contains("MCP connected", Qt::CaseInsensitive)) {
-            tagColor = "darkgreen";
-            lineColor = "green";
-        } else if (lineText.contains("MCP disconnected", Qt::CaseInsensitive)) {
-            tagColor = "maroon";
-            lineColor = "brown";
-        }
-    } else if (lineText.contains("WARN")) {
-    // format qWarning() generated lines
-        tagColor = bold ? "mediumblue" : "royalblue";
-        lineColor = "mediumblue";
-        m_lastCommandErrorRequest = false;
-    } else if (lineText.contains("CRIT")) {
-    // format qCritical() generated lines
-        tagColor = bold ? "firebrick" : "indianred";
-        lineColor = "firebrick";
-        m_lastCommandErrorRequest = false;
-    } else if (lineText.contains("FATL")) {
-    // format qFatal() generated lines
-        tagColor = bold ? "darkviolet" : "blueviolet";
-        lineColor = "darkviolet";
-        m_lastCommandErrorRequest = false;
-    } else {
-    // format all other lines
-        tagColor = bold ? "gray" : "darkgray";
-        lineColor = "gray";
-        m_lastCommandErrorRequest = false;
+    case QtInfoMsg:     line.level = LogInfo; break;
+    case QtWarningMsg:  line.level = LogWarning; break;
+    case QtCriticalMsg: line.level = LogCritical; break;
+    case QtFatalMsg:    line.level = LogFatal; break;
+    default:            line.level = LogOther; break;
     }
-    // generate HTML code for this line
-    QString line = "<div><span style=\"color:" + tagColor + ";\">" + lineTag + "</span>" \
-            "<span style=\"color:" + lineColor + ";font-weight:" + QString(bold ? "bold" : "regular") + ";\">" +
-            QString(italics ? "<i>" : "") + lineText.toHtmlEscaped() + QString(italics ? "</i>" : "") + "</span></div>";
-    ui->textMessage->appendHtml(line);
-    // ensure last line is visible
+    line.record = msg;
+    m_pendingLog.append(line);
+    // lines that would scroll out of the view right away are not rendered at all
+    if (m_pendingLog.size() > m_logMaxLines)
+        m_pendingLog.removeFirst();
+    if (!m_logFlushTimer->isActive())
+        m_logFlushTimer->start();
+}
+
+void MainWidget::flushLog()
+{
+    if (m_pendingLog.isEmpty())
+        return;
+    QTextDocument *doc = ui->textMessage->document();
+    QTextCursor cursor(doc);
     cursor.movePosition(QTextCursor::End);
-    cursor.movePosition(QTextCursor::StartOfLine);
-    ui->textMessage->setTextCursor(cursor);
-    ui->textMessage->ensureCursorVisible();
+    cursor.beginEditBlock();
+    for (const LOG_LINE &line : qAsConst(m_pendingLog)) {
+        if (!doc->isEmpty())
+            cursor.insertBlock();
+        cursor.insertText(tLogTimeTag(line.record.lastTime), m_logFormats[line.level][0]);
+        cursor.insertText(' ' + tLogText(line.record), m_logFormats[line.level][1]);
+    }
+    cursor.endEditBlock();
+    m_pendingLog.clear();
+    // ensure last line is visible
+    ui->textMessage->verticalScrollBar()->setValue(ui->textMessage->verticalScrollBar()->maximum());
 }
 
-void MainWidget::setMeasuredVoltage(double x)
+void MainWidget::setMeasuredVoltage(int channel, double x)
 {
+    if (channel != m_channel)
+        return;
     m_flags |= MeasuredVoltageReceived;
     ui->measuredVolts->setText(QString("%1 V").arg(x, 5, 'f', 2, QLatin1Char('0')));
 }
 
-void MainWidget::setMeasuredCurrent(double x)
+void MainWidget::setMeasuredCurrent(int channel, double x)
 {
+    if (channel != m_channel)
+        return;
     m_flags |= MeasuredCurrentReceived;
     ui->measuredAmps->setText(QString("%1 A").arg(x, 5, 'f', 2, QLatin1Char('0')));
 }
 
-void MainWidget::setMeasuredPower(double x)
+void MainWidget::setMeasuredPower(int channel, double x)
 {
+    if (channel != m_channel)
+        return;
     m_flags |= MeasuredPowerReceived;
     ui->measuredWatts->setText(QString("%1 W").arg(x, 5, 'f', 2, QLatin1Char('0')));
 }
 
-void MainWidget::setVoltageSet(double x)
+void MainWidget::setVoltageSet(int channel, double x)
 {
+    if (channel != m_channel)
+        return;
     m_flags |= SetVoltageReceived;
+    if (m_setVA && (qAbs(x - m_newVoltage) > 0.005))
+        return;
     if (!m_setVoltageChanged)
         SilentCall(ui->setVolts)->setValue(x);
 }
 
-void MainWidget::setCurrentSet(double x)
+void MainWidget::setCurrentSet(int channel, double x)
 {
+    if (channel != m_channel)
+        return;
     m_flags |= SetCurrentReceived;
+    if (m_setVA && (qAbs(x - m_newCurrent) > 0.005))
+        return;
     if (!m_setCurrentChanged)
         SilentCall(ui->setAmps)->setValue(x);
 }
 
-void MainWidget::setOnOff(bool x)
+void MainWidget::setOnOff(int channel, bool x)
 {
+    if (channel != m_channel)
+        return;
     m_flags |= OnOffReceived;
-    if (!m_setOnOff) {
+    if (!m_setOnOff || (x == m_newOnOff)) {
+        m_setOnOff = false;
         SilentCall(ui->onoff)->setChecked(x);
         setOnOffText(x);
     }
@@ -309,10 +478,20 @@ void MainWidget::printError(const QString &x)
 
 void MainWidget::on_onoff_toggled(bool checked)
 {
-    m_setOnOff = true;
     m_newOnOff = checked;
     qInfo() << "switch " << (checked ? "ON" : "OFF");
+    if (!m_dev) {
+        // nothing switched, keep showing the last known state
+        qCritical() << "not connected, output not switched";
+        SilentCall(ui->onoff)->setChecked(!checked);
+        return;
+    }
     setOnOffText(checked);
+    m_setOnOff = true;
+    m_holdOnOff = SET_HOLD_CYCLES;
+    m_retryOnOff = !m_dev->setOnOff(m_newOnOff, m_channel);
+    if (m_retryOnOff)
+        qWarning() << "command queue full, switching after the next poll cycle";
 }
 
 
@@ -320,14 +499,31 @@ void MainWidget::on_setVA_clicked()
 {
     m_newVoltage = ui->setVolts->value();
     m_newCurrent = ui->setAmps->value();
-    m_setVA = true;
     qInfo() << "set voltage to" << m_newVoltage << "V";
     qInfo() << "set current to" << m_newCurrent << "A";
+    if (!m_dev) {
+        // the values stay marked as changed
+        qCritical() << "not connected, setpoints not sent";
+        return;
+    }
+    m_setVA = true;
+    m_holdVA = SET_HOLD_CYCLES;
+    m_retryVA = !m_dev->setVoltageCurrent(m_newVoltage, m_newCurrent, m_channel);
+    if (m_retryVA)
+        qWarning() << "command queue full, setting after the next poll cycle";
+    m_setVoltageChanged = false;
+    m_setCurrentChanged = false;
+    ui->setVolts->setStyleSheet("color:white;");
+    ui->setAmps->setStyleSheet("color:white;");
 }
 
 void MainWidget::on_setVolts_valueChanged(double x)
 {
     Q_UNUSED(x)
+    if (ui->liveSetpoints->isChecked()) {
+        streamSetpoints();
+        return;
+    }
     m_setVoltageChanged = true;
     ui->setVolts->setStyleSheet("color:red;");
 }
@@ -336,10 +532,37 @@ void MainWidget::on_setVolts_valueChanged(double x)
 void MainWidget::on_setAmps_valueChanged(double x)
 {
     Q_UNUSED(x)
+    if (ui->liveSetpoints->isChecked()) {
+        streamSetpoints();
+        return;
+    }
     m_setCurrentChanged = true;
     ui->setAmps->setStyleSheet("color:red;");
 }
 
+void MainWidget::streamSetpoints()
+{
+    m_newVoltage = ui->setVolts->value();
+    m_newCurrent = ui->setAmps->value();
+    if (!m_dev)
+        return;
+    // a fast wheel spin ends up in a few writes, the device keeps the latest values only
+    m_dev->streamVoltageCurrent(m_newVoltage, m_newCurrent, m_channel);
+    m_setVA = true;
+    m_holdVA = SET_HOLD_CYCLES;
+}
+
+void MainWidget::on_liveSetpoints_toggled(bool checked)
+{
+    QSettings cfg;
+    cfg.beginGroup(GRP_DP700);
+    cfg.setValue(CFG_LIVE_SETPOINTS, checked);
+    cfg.endGroup();
+    // values changed before are sent now
+    if (checked && (m_setVoltageChanged || m_setCurrentChanged))
+        on_setVA_clicked();
+}
+
 void MainWidget::updateIndicator(bool connected)
 {
     const int maxIndicatorCount = 64;
@@ -372,17 +595,41 @@ void MainWidget::reconnectDevice(const QString &port)
 
 void MainWidget::disconnectDevice()
 {
-    delete m_dev;
+    // the device lives in the I/O thread and has to be deleted there,
+    // the scheduler is a child of the device and goes with it
+    if (m_dev) {
+        DP700 *dev = m_dev;
+        QMetaObject::invokeMethod(m_ioContext, [dev]() { delete dev; }, Qt::BlockingQueuedConnection);
+    }
+    m_dev = nullptr;
+    m_scheduler = nullptr;
+    m_polling = false;
+    // not retried on the next device, the UI shows what the instrument reports
+    if (m_retryOnOff)
+        qCritical() << "disconnected, output not switched";
+    if (m_retryVA) {
+        qCritical() << "disconnected, setpoints not sent";
+        m_setVoltageChanged = true;
+        m_setCurrentChanged = true;
+        ui->setVolts->setStyleSheet("color:red;");
+        ui->setAmps->setStyleSheet("color:red;");
+    }
+    m_retryOnOff = false;
+    m_retryVA = false;
+    m_setOnOff = false;
+    m_setVA = false;
     m_flags = 0;
-    killTimer(m_idUpdateTimer);
-    m_idUpdateTimer = 0;
     killTimer(m_idWatchdogTimer);
     m_idWatchdogTimer = 0;
+    killTimer(m_idReopenTimer);
+    m_idReopenTimer = 0;
 }
 
 void MainWidget::connectDevice(const QString &port)
 {
-    m_dev = new DP700(port, this);
+    m_dev = new DP700(port, m_baudRate ? m_baudRate : m_detectedBaudRate);
+    m_dev->setProfile(m_profile);
+    m_dev->setStreamRate(m_maxSetRate);
     connect(m_dev, &DP700::measuredVoltage, this, &MainWidget::setMeasuredVoltage);
     connect(m_dev, &DP700::measuredCurrent, this, &MainWidget::setMeasuredCurrent);
     connect(m_dev, &DP700::measuredPower, this, &MainWidget::setMeasuredPower);
@@ -392,15 +639,30 @@ void MainWidget::connectDevice(const QString &port)
     connect(m_dev, &DP700::idn, this, &MainWidget::printIdentification);
     connect(m_dev, &DP700::version, this, &MainWidget::printVersion);
     connect(m_dev, &DP700::error, this, &MainWidget::printError);
-
-    QTimer::singleShot(250, this, &MainWidget::startDevice);
+    connect(m_dev, &DP700::baudRateDetected, this, &MainWidget::onBaudRateDetected);
+    connect(m_dev, &DP700::baudRateDetectionFailed, this, &MainWidget::onBaudRateDetectionFailed);
+    connect(m_dev, &DP700::statistics, ui->linkStats, &QLabel::setText);
+    connect(m_dev, &DP700::linkLost, this, [this]() { updateIndicator(false); });
+    connect(m_dev, &SerDev::portError, this, &MainWidget::onPortError);
+    connect(m_dev, &DP700::sampled, ui->trend, [this](const SAMPLE &x) { if (x.channel == m_channel) ui->trend->addSample(x); });
+    if (m_recorder)
+        connectRecorder();
+
+    m_scheduler = new PollScheduler(m_dev, m_dev);
+    m_scheduler->setMaxRate(m_maxPollRate);
+    connect(m_scheduler, &PollScheduler::cycleComplete, this, &MainWidget::onCycleComplete);
+    connect(m_scheduler, &PollScheduler::rateMeasured, this, &MainWidget::setPollRate);
+    m_dev->moveToThread(m_ioThread);
+
+    connect(m_dev, &SerDev::opened, this, &MainWidget::startDevice);
+    QMetaObject::invokeMethod(m_dev, "open", Qt::QueuedConnection);
 }
 
 
 void MainWidget::triggerWatchdog()
 {
     killTimer(m_idWatchdogTimer);
-    qDebug() << "   -> trigger watchdog";
+    qCDebug(lcPoll) << "trigger watchdog";
     m_idWatchdogTimer = startTimer(WATCHDOG_MS);
 }
 
@@ -416,6 +678,59 @@ void MainWidget::on_alwaysOnTop_toggled(bool checked)
     show();
 }
 
+void MainWidget::on_record_toggled(bool checked)
+{
+    if (!checked) {
+        stopRecording();
+        return;
+    }
+    QSettings cfg;
+    cfg.beginGroup(GRP_DP700);
+    QString name = QFileDialog::getSaveFileName(this, tr("Record Samples"), cfg.value(CFG_RECORDING).toString(),
+                                                tr("DP700 recordings (*.dp7rec);;All files (*)"), nullptr,
+                                                QFileDialog::DontConfirmOverwrite);
+    if (name.isEmpty()) {
+        SilentCall(ui->record)->setChecked(false);
+        return;
+    }
+    cfg.setValue(CFG_RECORDING, name);
+    cfg.endGroup();
+    SampleRecorder *recorder = new SampleRecorder;
+    recorder->moveToThread(m_ioThread);
+    bool ok = false;
+    QMetaObject::invokeMethod(recorder, "open", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, ok), Q_ARG(QString, name));
+    if (!ok) {
+        QMetaObject::invokeMethod(m_ioContext, [recorder]() { delete recorder; }, Qt::BlockingQueuedConnection);
+        SilentCall(ui->record)->setChecked(false);
+        QMessageBox::warning(this, qApp->applicationDisplayName(), tr("Cannot record to %1").arg(name));
+        return;
+    }
+    m_recorder = recorder;
+    if (m_dev)
+        connectRecorder();
+}
+
+void MainWidget::connectRecorder()
+{
+    // both live in the I/O thread, samples are recorded without a queued copy
+    SampleRecorder *recorder = m_recorder;
+    int channel = m_channel;
+    connect(m_dev, &DP700::sampled, m_recorder, [recorder, channel](const SAMPLE &x) {
+        if (x.channel == channel)
+            recorder->append(x);
+    }, Qt::DirectConnection);
+}
+
+void MainWidget::stopRecording()
+{
+    // closed and deleted in the I/O thread, no sample is appended after that
+    if (m_recorder) {
+        SampleRecorder *recorder = m_recorder;
+        QMetaObject::invokeMethod(m_ioContext, [recorder]() { delete recorder; }, Qt::BlockingQueuedConnection);
+    }
+    m_recorder = nullptr;
+}
+
 void MainWidget::onSuspend()
 {
     qInfo() << "suspending DP700 communications";
@@ -439,3 +754,32 @@ void MainWidget::on_serialPort_currentIndexChanged(int index)
         qDebug() << "new serial port:" << m_port << "(" << m_serialPortIndex << ")";
     }
 }
+
+void MainWidget::on_baudRate_currentIndexChanged(int index)
+{
+    quint32 baudrate = ui->baudRate->itemData(index).toUInt();
+    if (m_baudRate != baudrate) {
+        m_baudRate = baudrate;
+        QSettings cfg;
+        cfg.setValue(CFG_BAUDRATE, m_baudRate);
+        qDebug() << "new baud rate:" << m_baudRate;
+        reconnectDevice(m_port);
+    }
+}
+
+void MainWidget::on_maxPollRate_valueChanged(double x)
+{
+    m_maxPollRate = x;
+    QSettings cfg;
+    cfg.beginGroup(GRP_DP700);
+    cfg.setValue(CFG_MAX_POLL_RATE, m_maxPollRate);
+    cfg.endGroup();
+    if (m_scheduler)
+        QMetaObject::invokeMethod(m_scheduler, "setMaxRate", Qt::QueuedConnection, Q_ARG(double, m_maxPollRate));
+}
+
+void MainWidget::on_dumpStats_clicked()
+{
+    if (m_dev)
+        QMetaObject::invokeMethod(m_dev, "dumpStatistics", Qt::QueuedConnection);
+}
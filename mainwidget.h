@@ -14,12 +14,20 @@
 #define MAINWIDGET_H
 
 #include "tmainwidget.h"
+#include <QTextCharFormat>
+#include "tlogrecord.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWidget; }
 QT_END_NAMESPACE
 
 class DP700;
+class PollScheduler;
+class SampleRecorder;
+class InstrumentProfile;
+class PortWatcher;
+class QThread;
+class QTimer;
 
 class MainWidget : public TMainWidget
 {
@@ -34,14 +42,23 @@ protected:
 
 
 private slots:
-    void startDevice();
-    void on_messageAdded(const QString &msg);
-    void setMeasuredVoltage(double x);
-    void setMeasuredCurrent(double x);
-    void setMeasuredPower(double x);
-    void setVoltageSet(double x);
-    void setCurrentSet(double x);
-    void setOnOff(bool x);
+    void startDevice(bool ok);
+    void onCycleComplete();
+    void setPollRate(double x);
+    void onBaudRateDetected(quint32 baudrate);
+    void onBaudRateDetectionFailed();
+    void onPortError(const QString &text);
+    void setSerialPorts(const QStringList &ports);
+    void onPortAdded(const QString &port);
+    void onPortRemoved(const QString &port);
+    void on_messageAdded(const TLOG_RECORD &msg);
+    void flushLog();
+    void setMeasuredVoltage(int channel, double x);
+    void setMeasuredCurrent(int channel, double x);
+    void setMeasuredPower(int channel, double x);
+    void setVoltageSet(int channel, double x);
+    void setCurrentSet(int channel, double x);
+    void setOnOff(int channel, bool x);
     void printIdentification(const QString &x);
     void printVersion(const QString &x);
     void printError(const QString &x);
@@ -53,9 +70,14 @@ private slots:
     void on_setVolts_valueChanged(double x);
     void on_setAmps_valueChanged(double x);
     void on_serialPort_currentIndexChanged(int index);
+    void on_baudRate_currentIndexChanged(int index);
+    void on_maxPollRate_valueChanged(double x);
+    void on_dumpStats_clicked();
 
     void updateIndicator(bool connected);
     void on_alwaysOnTop_toggled(bool checked);
+    void on_record_toggled(bool checked);
+    void on_liveSetpoints_toggled(bool checked);
 
 private:
     Ui::MainWidget *ui;
@@ -72,17 +94,36 @@ private:
         ErrorReceived           = 0x00000100,
     } MessageFlags;
 
+    typedef enum {
+        LogInfo,
+        LogWarning,
+        LogCritical,
+        LogFatal,
+        LogOther,
+        LOG_LEVELS
+    } LOG_LEVEL;
+
+    typedef struct {
+        LOG_LEVEL   level;
+        TLOG_RECORD record;         // formatted when it is rendered
+    } LOG_LINE;
+
     void setOnOffText(bool on);
     void reconnectDevice(const QString &port);
     void disconnectDevice();
     void connectDevice(const QString &port);
+    void startPolling();
     void triggerWatchdog();
+    void stopRecording();
+    void connectRecorder();
+    void streamSetpoints();
 
-    bool            m_lastCommandErrorRequest;
     DP700           *m_dev;
     quint32         m_flags;
-    int             m_idUpdateTimer;
+    PollScheduler   *m_scheduler;
+    bool            m_polling;              // the device recovers from stalls itself
     int             m_idWatchdogTimer;
+    int             m_idReopenTimer;        // the port is present but could not be opened
     bool            m_setOnOff;
     bool            m_newOnOff;
     bool            m_setVA;
@@ -93,6 +134,26 @@ private:
     int             m_indicatorCount, m_indicatorInc;
     QString         m_port;
     int             m_serialPortIndex;
+    QStringList     m_serialPorts;          // present ones, as last reported by the port watcher
+    quint32         m_baudRate;             // 0: auto detect
+    quint32         m_detectedBaudRate;
+    double          m_maxPollRate;          // 0: unlimited
+    int             m_holdOnOff;
+    int             m_holdVA;
+    bool            m_retryOnOff;           // did not fit into the command queue, sent again
+    bool            m_retryVA;              // after the next poll cycle
+    const InstrumentProfile *m_profile;     // model of the instrument
+    int             m_channel;              // the one shown and controlled, counting from 1
+    double          m_maxSetRate;           // live setpoint writes per second
+    QThread         *m_ioThread;
+    QObject         *m_ioContext;           // lives in m_ioThread to run code there
+    QThread         *m_portThread;
+    PortWatcher     *m_portWatcher;         // lives in m_portThread
+    SampleRecorder  *m_recorder;            // lives in m_ioThread, nullptr if not recording
+    QList<LOG_LINE> m_pendingLog;           // not rendered yet
+    QTimer          *m_logFlushTimer;
+    int             m_logMaxLines;
+    QTextCharFormat m_logFormats[LOG_LEVELS][2];    // tag, text
 };
 
 #endif // MAINWIDGET_H
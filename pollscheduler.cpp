@@ -0,0 +1,103 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// pollscheduler.cpp
+// event driven poll cycle scheduler
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "pollscheduler.h"
+#include "dp700.h"
+#include <QTimer>
+#include <QDebug>
+
+// report the achieved poll rate that often
+#define RATE_REPORT_MS  1000
+// a cycle taking longer than SLOW_FACTOR times the average counts as slow
+#define SLOW_FACTOR     2.0
+#define BACKOFF_MIN_MS  10
+#define BACKOFF_MAX_MS  500
+
+PollScheduler::PollScheduler(DP700 *dev, QObject *parent)
+    : QObject(parent)
+    , m_dev(dev)
+    , m_delayTimer(new QTimer(this))
+    , m_running(false)
+    , m_minPeriodMs(0)
+    , m_avgCycleMs(0)
+    , m_backoffMs(0)
+    , m_cycles(0)
+{
+    m_delayTimer->setSingleShot(true);
+    m_delayTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_delayTimer, &QTimer::timeout, this, &PollScheduler::startCycle);
+    connect(m_dev, &DP700::pollComplete, this, &PollScheduler::onPollComplete);
+}
+
+void PollScheduler::start()
+{
+    m_running = true;
+    m_avgCycleMs = 0;
+    m_backoffMs = 0;
+    m_cycles = 0;
+    m_rateTime.start();
+    startCycle();
+}
+
+void PollScheduler::stop()
+{
+    m_running = false;
+    m_delayTimer->stop();
+}
+
+void PollScheduler::setMaxRate(double cyclesPerSecond)
+{
+    m_minPeriodMs = (cyclesPerSecond > 0) ? 1000.0 / cyclesPerSecond : 0;
+}
+
+void PollScheduler::startCycle()
+{
+    if (!m_running)
+        return;
+    m_cycleTime.start();
+    if (!m_dev->measureAll()) {
+        // command queue is full, try again a little later
+        m_backoffMs = qBound(BACKOFF_MIN_MS, 2*m_backoffMs, BACKOFF_MAX_MS);
+        m_delayTimer->start(m_backoffMs);
+    }
+}
+
+void PollScheduler::onPollComplete()
+{
+    if (!m_running)
+        return;
+    double cycleMs = m_cycleTime.nsecsElapsed() / 1e6;
+    // back off while the instrument answers slower than usual, recover gradually
+    if ((m_avgCycleMs > 0) && (cycleMs > SLOW_FACTOR * m_avgCycleMs)) {
+        m_backoffMs = qBound(BACKOFF_MIN_MS, 2*m_backoffMs, BACKOFF_MAX_MS);
+    } else {
+        m_backoffMs = (m_backoffMs > BACKOFF_MIN_MS) ? m_backoffMs/2 : 0;
+    }
+    m_avgCycleMs = (m_avgCycleMs > 0) ? (7*m_avgCycleMs + cycleMs) / 8 : cycleMs;
+
+    ++m_cycles;
+    qint64 dT = m_rateTime.elapsed();
+    if (dT >= RATE_REPORT_MS) {
+        emit rateMeasured(1000.0 * m_cycles / dT);
+        m_cycles = 0;
+        m_rateTime.start();
+    }
+
+    // let the listeners queue their commands before the next cycle
+    emit cycleComplete();
+
+    int delayMs = m_backoffMs + qMax(0, int(m_minPeriodMs - cycleMs));
+    if (delayMs > 0)
+        m_delayTimer->start(delayMs);
+    else
+        startCycle();
+}
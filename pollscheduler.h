@@ -0,0 +1,53 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// pollscheduler.h
+// event driven poll cycle scheduler, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef POLLSCHEDULER_H
+#define POLLSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+class DP700;
+class QTimer;
+
+class PollScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PollScheduler(DP700 *dev, QObject *parent = nullptr);
+
+public slots:
+    void start();
+    void stop();
+    void setMaxRate(double cyclesPerSecond);    // 0: poll as fast as the instrument answers
+
+signals:
+    void cycleComplete();
+    void rateMeasured(double cyclesPerSecond);
+
+private slots:
+    void startCycle();
+    void onPollComplete();
+
+private:
+    DP700           *m_dev;
+    QTimer          *m_delayTimer;
+    QElapsedTimer   m_cycleTime;
+    QElapsedTimer   m_rateTime;
+    bool            m_running;
+    double          m_minPeriodMs;
+    double          m_avgCycleMs;
+    int             m_backoffMs;
+    int             m_cycles;
+};
+
+#endif // POLLSCHEDULER_H
@@ -0,0 +1,128 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// portwatcher.cpp
+// serial port discovery and hotplug monitoring
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "portwatcher.h"
+#include <QSerialPortInfo>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QDebug>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// udev creates the device node a little after the kernel event, rescan that much later
+#define UEVENT_SETTLE_MS    500
+// without hotplug events the port list is polled that often
+#define POLL_MS             2000
+#define UEVENT_BUFFER_SIZE  4096
+
+PortWatcher::PortWatcher(QObject *parent)
+    : QObject(parent)
+    , m_rescanTimer(new QTimer(this))
+    , m_notifier(nullptr)
+    , m_ueventSocket(-1)
+{
+    connect(m_rescanTimer, &QTimer::timeout, this, &PortWatcher::rescan);
+}
+
+PortWatcher::~PortWatcher()
+{
+#ifdef Q_OS_LINUX
+    delete m_notifier;
+    if (m_ueventSocket >= 0)
+        ::close(m_ueventSocket);
+#endif
+}
+
+void PortWatcher::start()
+{
+    if (openUevents()) {
+        // a burst of events causes one rescan
+        m_rescanTimer->setSingleShot(true);
+        m_rescanTimer->setInterval(UEVENT_SETTLE_MS);
+    } else {
+        m_rescanTimer->setSingleShot(false);
+        m_rescanTimer->start(POLL_MS);
+    }
+    rescan();
+}
+
+void PortWatcher::rescan()
+{
+    QStringList ports;
+    for (const QSerialPortInfo &info : QSerialPortInfo::availablePorts())
+        ports << info.portName();
+    ports.sort();
+    if (ports == m_ports)
+        return;
+    QStringList old = m_ports;
+    m_ports = ports;
+    emit portsChanged(ports);
+    for (const QString &port : qAsConst(old)) {
+        if (!ports.contains(port))
+            emit portRemoved(port);
+    }
+    for (const QString &port : qAsConst(ports)) {
+        if (!old.contains(port))
+            emit portAdded(port);
+    }
+}
+
+bool PortWatcher::openUevents()
+{
+#ifdef Q_OS_LINUX
+    // kernel uevents straight from netlink, the same udev listens to, no library needed
+    m_ueventSocket = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (m_ueventSocket < 0)
+        return false;
+    sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;
+    if (::bind(m_ueventSocket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        qWarning() << "no hotplug events, polling the serial ports:" << strerror(errno);
+        ::close(m_ueventSocket);
+        m_ueventSocket = -1;
+        return false;
+    }
+    m_notifier = new QSocketNotifier(m_ueventSocket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &PortWatcher::onUevent);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PortWatcher::onUevent()
+{
+#ifdef Q_OS_LINUX
+    char buf[UEVENT_BUFFER_SIZE];
+    bool tty = false;
+    ssize_t n;
+    while ((n = ::recv(m_ueventSocket, buf, sizeof(buf) - 1, 0)) > 0) {
+        // "ACTION@DEVPATH" followed by "KEY=value" strings, each terminated by '\0'
+        buf[n] = 0;
+        for (const char *p = buf; p < buf + n; p += strlen(p) + 1) {
+            if (strcmp(p, "SUBSYSTEM=tty") == 0) {
+                tty = true;
+                break;
+            }
+        }
+    }
+    if (tty)
+        m_rescanTimer->start();
+#endif
+}
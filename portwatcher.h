@@ -0,0 +1,55 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// portwatcher.h
+// serial port discovery and hotplug monitoring, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef PORTWATCHER_H
+#define PORTWATCHER_H
+
+#include <QObject>
+#include <QStringList>
+
+class QTimer;
+class QSocketNotifier;
+
+// Enumerates the serial ports in the thread it lives in, so a slow enumeration
+// never delays the GUI or the serial I/O. On Linux the port list is refreshed
+// on kernel uevents of the tty subsystem, elsewhere it is polled.
+class PortWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PortWatcher(QObject *parent = nullptr);
+    ~PortWatcher();
+
+public slots:
+    // call in the thread the watcher lives in
+    void start();
+    void rescan();
+
+signals:
+    // complete list, sorted by name
+    void portsChanged(const QStringList &ports);
+    void portAdded(const QString &port);
+    void portRemoved(const QString &port);
+
+private slots:
+    void onUevent();
+
+private:
+    bool openUevents();
+
+    QStringList     m_ports;
+    QTimer          *m_rescanTimer;
+    QSocketNotifier *m_notifier;
+    int             m_ueventSocket;     // -1 if not available
+};
+
+#endif // PORTWATCHER_H
@@ -0,0 +1,31 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// sample.h
+// one complete set of readings from a poll cycle
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <QMetaType>
+
+typedef struct {
+    qint64  timestamp;      // ms since epoch, time the measurement was received
+    double  voltage;
+    double  current;
+    double  power;
+    double  setVoltage;
+    double  setCurrent;
+    bool    on;
+    int     channel;        // output of the instrument, counting from 1
+} SAMPLE;
+
+Q_DECLARE_METATYPE(SAMPLE)
+
+#endif // SAMPLE_H
@@ -0,0 +1,361 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// samplearchive.cpp
+// compressed, indexed long-term sample archive
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "samplearchive.h"
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// zlib level, blocks are written rarely so favour size
+#define ARCHIVE_COMPRESSION 9
+// quantized value columns, in this order after the timestamps
+#define VALUE_COLUMNS       5
+
+static quint64 zigzag(qint64 x)
+{
+    return (quint64(x) << 1) ^ quint64(x >> 63);
+}
+
+static qint64 unzigzag(quint64 x)
+{
+    return qint64(x >> 1) ^ -qint64(x & 1);
+}
+
+static void putVarint(QByteArray &a, qint64 x)
+{
+    quint64 u = zigzag(x);
+    while (u >= 0x80) {
+        a.append(char(u | 0x80));
+        u >>= 7;
+    }
+    a.append(char(u));
+}
+
+static bool getVarint(const char *&p, const char *end, qint64 &x)
+{
+    quint64 u = 0;
+    for (int shift=0; (p < end) && (shift < 64); shift += 7) {
+        quint8 b = quint8(*p++);
+        u |= quint64(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            x = unzigzag(u);
+            return true;
+        }
+    }
+    return false;
+}
+
+static qint64 quantize(double x)
+{
+    return qint64(std::llround(x * ARCHIVE_RESOLUTION));
+}
+
+static double valueOf(const SAMPLE &x, int column)
+{
+    switch (column) {
+    case 0: return x.voltage;
+    case 1: return x.current;
+    case 2: return x.power;
+    case 3: return x.setVoltage;
+    default: return x.setCurrent;
+    }
+}
+
+static void setValue(SAMPLE &x, int column, double v)
+{
+    switch (column) {
+    case 0: x.voltage = v; break;
+    case 1: x.current = v; break;
+    case 2: x.power = v; break;
+    case 3: x.setVoltage = v; break;
+    default: x.setCurrent = v; break;
+    }
+}
+
+// builds the index from the trailer or, if there is none, from the block headers,
+// dataEnd is the offset behind the last complete block
+static bool loadIndex(QFile &f, QVector<ARCHIVE_INDEX_ENTRY> &index, qint64 &dataEnd)
+{
+    index.clear();
+    ARCHIVE_HEADER h;
+    if (!f.seek(0) || (f.read(reinterpret_cast<char *>(&h), sizeof(h)) != qint64(sizeof(h)))
+            || memcmp(h.magic, ARCHIVE_MAGIC, sizeof(h.magic)) || (h.version != ARCHIVE_VERSION))
+        return false;
+    qint64 size = f.size();
+    ARCHIVE_TRAILER t;
+    if ((size >= qint64(sizeof(h) + sizeof(t))) && f.seek(size - qint64(sizeof(t)))
+            && (f.read(reinterpret_cast<char *>(&t), sizeof(t)) == qint64(sizeof(t)))
+            && !memcmp(t.magic, ARCHIVE_TRAILER_MAGIC, sizeof(t.magic))
+            && (t.indexOffset + qint64(t.blocks * sizeof(ARCHIVE_INDEX_ENTRY) + sizeof(t)) == size)
+            && f.seek(t.indexOffset)) {
+        index.resize(int(t.blocks));
+        qint64 n = qint64(t.blocks * sizeof(ARCHIVE_INDEX_ENTRY));
+        if (f.read(reinterpret_cast<char *>(index.data()), n) == n) {
+            dataEnd = t.indexOffset;
+            return true;
+        }
+        index.clear();
+    }
+    // not closed properly, the block headers are read without their payload
+    qWarning() << f.fileName() << "has no index, scanning blocks";
+    qint64 pos = sizeof(h);
+    ARCHIVE_BLOCK b;
+    while (f.seek(pos) && (f.read(reinterpret_cast<char *>(&b), sizeof(b)) == qint64(sizeof(b)))
+           && (b.magic == ARCHIVE_BLOCK_MAGIC)
+           && (pos + qint64(sizeof(b)) + b.size <= size)) {
+        ARCHIVE_INDEX_ENTRY e;
+        e.firstTime = b.firstTime;
+        e.lastTime = b.lastTime;
+        e.offset = pos;
+        e.count = b.count;
+        e.reserved = 0;
+        index.append(e);
+        pos += qint64(sizeof(b)) + b.size;
+    }
+    dataEnd = pos;
+    return true;
+}
+
+
+SampleArchive::SampleArchive(QObject *parent)
+    : QObject(parent)
+    , m_file(this)          // moves to the archiving thread along with us
+    , m_samples(0)
+{
+    m_block.reserve(ARCHIVE_BLOCK_SAMPLES);
+    // a reserved QByteArray keeps its capacity on resize(0)
+    m_raw.reserve(ARCHIVE_BLOCK_SAMPLES * 8);
+}
+
+SampleArchive::~SampleArchive()
+{
+    close();
+}
+
+bool SampleArchive::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "cannot open archive" << fileName << m_file.errorString();
+        return false;
+    }
+    qint64 dataEnd = 0;
+    if (loadIndex(m_file, m_index, dataEnd)) {
+        // continue behind the last block, the index is written again on close
+        if (!m_file.resize(dataEnd) || !m_file.seek(dataEnd)) {
+            qWarning() << "cannot append to archive" << fileName << m_file.errorString();
+            m_file.close();
+            return false;
+        }
+        qInfo().nospace() << "archiving to " << fileName << ", continuing after " << m_index.size() << " blocks";
+    } else {
+        ARCHIVE_HEADER h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, ARCHIVE_MAGIC, sizeof(h.magic));
+        h.version = ARCHIVE_VERSION;
+        h.created = QDateTime::currentMSecsSinceEpoch();
+        m_index.clear();
+        if (!m_file.resize(0) || !m_file.seek(0) || (m_file.write(reinterpret_cast<const char *>(&h), sizeof(h)) != qint64(sizeof(h)))) {
+            qWarning() << "cannot write archive" << fileName << m_file.errorString();
+            m_file.close();
+            return false;
+        }
+        qInfo() << "archiving to" << fileName;
+    }
+    m_block.clear();
+    m_samples = 0;
+    return true;
+}
+
+void SampleArchive::close()
+{
+    if (!m_file.isOpen())
+        return;
+    writeBlock();
+    ARCHIVE_TRAILER t;
+    memset(&t, 0, sizeof(t));
+    memcpy(t.magic, ARCHIVE_TRAILER_MAGIC, sizeof(t.magic));
+    t.indexOffset = m_file.pos();
+    t.blocks = quint32(m_index.size());
+    m_file.write(reinterpret_cast<const char *>(m_index.constData()), qint64(m_index.size() * sizeof(ARCHIVE_INDEX_ENTRY)));
+    m_file.write(reinterpret_cast<const char *>(&t), sizeof(t));
+    m_file.close();
+    qInfo().nospace() << "archive " << m_file.fileName() << " closed, " << m_samples << " samples added";
+}
+
+void SampleArchive::append(const SAMPLE &x)
+{
+    if (!m_file.isOpen())
+        return;
+    if (!m_block.isEmpty() && (x.timestamp - m_block.first().timestamp >= ARCHIVE_BLOCK_MS))
+        writeBlock();
+    m_block.append(x);
+    ++m_samples;
+    if (m_block.size() >= ARCHIVE_BLOCK_SAMPLES)
+        writeBlock();
+}
+
+bool SampleArchive::writeBlock()
+{
+    if (m_block.isEmpty())
+        return true;
+    m_raw.resize(0);
+    // timestamps, the first one is in the block header
+    qint64 lastDelta = 0;
+    for (int i=1; i<m_block.size(); ++i) {
+        qint64 delta = m_block.at(i).timestamp - m_block.at(i-1).timestamp;
+        putVarint(m_raw, delta - lastDelta);
+        lastDelta = delta;
+    }
+    for (int column=0; column<VALUE_COLUMNS; ++column) {
+        qint64 last = 0;
+        for (const SAMPLE &x : m_block) {
+            qint64 q = quantize(valueOf(x, column));
+            putVarint(m_raw, q - last);
+            last = q;
+        }
+    }
+    qint64 lastOn = 0;
+    for (const SAMPLE &x : m_block) {
+        putVarint(m_raw, qint64(x.on) - lastOn);
+        lastOn = x.on;
+    }
+    QByteArray payload = qCompress(m_raw, ARCHIVE_COMPRESSION);
+
+    ARCHIVE_BLOCK b;
+    b.magic = ARCHIVE_BLOCK_MAGIC;
+    b.count = quint32(m_block.size());
+    b.firstTime = m_block.first().timestamp;
+    b.lastTime = m_block.last().timestamp;
+    b.size = quint32(payload.size());
+    b.reserved = 0;
+    ARCHIVE_INDEX_ENTRY e;
+    e.firstTime = b.firstTime;
+    e.lastTime = b.lastTime;
+    e.offset = m_file.pos();
+    e.count = b.count;
+    e.reserved = 0;
+    m_block.clear();
+    if ((m_file.write(reinterpret_cast<const char *>(&b), sizeof(b)) != qint64(sizeof(b)))
+            || (m_file.write(payload) != payload.size())) {
+        qWarning() << "cannot write archive" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    // a complete block survives a crash of the application
+    m_file.flush();
+    m_index.append(e);
+    return true;
+}
+
+
+bool SampleArchiveReader::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "cannot open archive" << fileName << m_file.errorString();
+        return false;
+    }
+    qint64 dataEnd;
+    if (!loadIndex(m_file, m_index, dataEnd)) {
+        qWarning() << fileName << "is not a DP700 archive";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SampleArchiveReader::close()
+{
+    m_index.clear();
+    m_file.close();
+}
+
+quint64 SampleArchiveReader::samples() const
+{
+    quint64 n = 0;
+    for (const ARCHIVE_INDEX_ENTRY &e : m_index)
+        n += e.count;
+    return n;
+}
+
+bool SampleArchiveReader::read(qint64 from, qint64 to, QVector<SAMPLE> &samples)
+{
+    // blocks are in time order, skip all that end before the range
+    auto it = std::lower_bound(m_index.constBegin(), m_index.constEnd(), from,
+                               [](const ARCHIVE_INDEX_ENTRY &e, qint64 t) { return e.lastTime < t; });
+    for (; (it != m_index.constEnd()) && (it->firstTime <= to); ++it) {
+        ARCHIVE_BLOCK b;
+        if (!m_file.seek(it->offset) || (m_file.read(reinterpret_cast<char *>(&b), sizeof(b)) != qint64(sizeof(b)))
+                || (b.magic != ARCHIVE_BLOCK_MAGIC) || (b.count == 0) || (b.count != it->count)) {
+            qWarning() << "damaged block header at" << it->offset;
+            return false;
+        }
+        m_payload.resize(int(b.size));
+        if (m_file.read(m_payload.data(), b.size) != qint64(b.size)) {
+            qWarning() << "truncated block at" << it->offset;
+            return false;
+        }
+        QByteArray raw = qUncompress(m_payload);
+        const char *p = raw.constData();
+        const char *end = p + raw.size();
+
+        int first = samples.size();
+        int n = int(b.count);
+        samples.resize(first + n);
+        SAMPLE *s = samples.data() + first;
+        bool ok = true;
+        qint64 t = b.firstTime;
+        qint64 delta = 0;
+        s[0].timestamp = t;
+        for (int i=1; ok && (i<n); ++i) {
+            qint64 dod;
+            ok = getVarint(p, end, dod);
+            delta += dod;
+            t += delta;
+            s[i].timestamp = t;
+        }
+        for (int column=0; ok && (column<VALUE_COLUMNS); ++column) {
+            qint64 q = 0;
+            for (int i=0; ok && (i<n); ++i) {
+                qint64 d;
+                ok = getVarint(p, end, d);
+                q += d;
+                setValue(s[i], column, q / ARCHIVE_RESOLUTION);
+            }
+        }
+        qint64 on = 0;
+        for (int i=0; ok && (i<n); ++i) {
+            qint64 d;
+            ok = getVarint(p, end, d);
+            on += d;
+            s[i].on = (on != 0);
+            // an archive holds the samples of one output
+            s[i].channel = 1;
+        }
+        if (!ok) {
+            qWarning() << "damaged block at" << it->offset;
+            samples.resize(first);
+            return false;
+        }
+        // only the first and the last block may reach outside the range
+        if ((b.firstTime < from) || (b.lastTime > to)) {
+            auto keep = std::remove_if(samples.begin() + first, samples.end(),
+                                       [from, to](const SAMPLE &x) { return (x.timestamp < from) || (x.timestamp > to); });
+            samples.erase(keep, samples.end());
+        }
+    }
+    return true;
+}
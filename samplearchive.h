@@ -0,0 +1,124 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// samplearchive.h
+// compressed, indexed long-term sample archive, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef SAMPLEARCHIVE_H
+#define SAMPLEARCHIVE_H
+
+#include <QObject>
+#include <QFile>
+#include <QVector>
+#include "sample.h"
+
+// file layout, all values in host byte order:
+//   ARCHIVE_HEADER
+//   ARCHIVE_BLOCK + compressed payload, repeated
+//   ARCHIVE_INDEX_ENTRY for every block, written on close
+//   ARCHIVE_TRAILER
+// Every block decodes on its own. Inside a block the samples are stored
+// column by column: timestamps as delta-of-delta, the values quantized to
+// ARCHIVE_RESOLUTION and delta coded, all as zigzag varints, the columns
+// then compressed with zlib. A file without trailer (the writer did not
+// close it) is indexed by walking the block headers.
+#define ARCHIVE_MAGIC           "DP700ARC"
+#define ARCHIVE_TRAILER_MAGIC   "DP700IDX"
+#define ARCHIVE_BLOCK_MAGIC     0x4b4c4250      // "PBLK"
+#define ARCHIVE_VERSION         1
+#define ARCHIVE_RESOLUTION      1000.0          // 1 mV, 1 mA, 1 mW
+// a block is written when it holds that many samples or spans that much time
+#define ARCHIVE_BLOCK_SAMPLES   4096
+#define ARCHIVE_BLOCK_MS        (10*60*1000)
+
+typedef struct {
+    char    magic[8];       // ARCHIVE_MAGIC, not terminated
+    quint32 version;
+    quint32 reserved;
+    qint64  created;        // ms since epoch
+} ARCHIVE_HEADER;
+
+typedef struct {
+    quint32 magic;          // ARCHIVE_BLOCK_MAGIC
+    quint32 count;          // samples in the block
+    qint64  firstTime;
+    qint64  lastTime;
+    quint32 size;           // payload bytes following this header
+    quint32 reserved;
+} ARCHIVE_BLOCK;
+
+typedef struct {
+    qint64  firstTime;
+    qint64  lastTime;
+    qint64  offset;         // of the ARCHIVE_BLOCK
+    quint32 count;
+    quint32 reserved;
+} ARCHIVE_INDEX_ENTRY;
+
+typedef struct {
+    char    magic[8];       // ARCHIVE_TRAILER_MAGIC, not terminated
+    qint64  indexOffset;
+    quint32 blocks;
+    quint32 reserved;
+} ARCHIVE_TRAILER;
+
+Q_STATIC_ASSERT(sizeof(ARCHIVE_HEADER) == 24);
+Q_STATIC_ASSERT(sizeof(ARCHIVE_BLOCK) == 32);
+Q_STATIC_ASSERT(sizeof(ARCHIVE_INDEX_ENTRY) == 32);
+Q_STATIC_ASSERT(sizeof(ARCHIVE_TRAILER) == 24);
+
+// collects samples into blocks and appends them to an archive
+class SampleArchive : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SampleArchive(QObject *parent = nullptr);
+    ~SampleArchive();
+
+    bool isOpen() const { return m_file.isOpen(); }
+
+public slots:
+    // an existing archive is continued, anything else is replaced
+    bool open(const QString &fileName);
+    // writes the pending block and the index
+    void close();
+    void append(const SAMPLE &x);
+
+private:
+    bool writeBlock();
+
+    QFile                           m_file;
+    QVector<SAMPLE>                 m_block;        // samples of the block being collected
+    QVector<ARCHIVE_INDEX_ENTRY>    m_index;
+    QByteArray                      m_raw;          // encoding buffer, reused for every block
+    quint64                         m_samples;
+};
+
+// reads time ranges from an archive, touching the blocks in the range only
+class SampleArchiveReader
+{
+public:
+    bool open(const QString &fileName);
+    void close();
+
+    int blocks() const { return m_index.size(); }
+    quint64 samples() const;
+    qint64 firstTime() const { return m_index.isEmpty() ? 0 : m_index.first().firstTime; }
+    qint64 lastTime() const { return m_index.isEmpty() ? 0 : m_index.last().lastTime; }
+
+    // appends all samples with from <= timestamp <= to, false on a damaged block
+    bool read(qint64 from, qint64 to, QVector<SAMPLE> &samples);
+
+private:
+    QFile                           m_file;
+    QVector<ARCHIVE_INDEX_ENTRY>    m_index;
+    QByteArray                      m_payload;
+};
+
+#endif // SAMPLEARCHIVE_H
@@ -0,0 +1,217 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// samplerecorder.cpp
+// binary memory mapped sample recording
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "samplerecorder.h"
+#include <QDateTime>
+#include <QDebug>
+#include <atomic>
+#include <cstring>
+
+static qint64 fileSize(quint64 records)
+{
+    return qint64(sizeof(RECORDING_HEADER) + records * sizeof(SAMPLE_RECORD));
+}
+
+static bool isValidHeader(const RECORDING_HEADER *h)
+{
+    return !memcmp(h->magic, RECORDING_MAGIC, sizeof(h->magic))
+        && (h->version == RECORDING_VERSION)
+        && (h->recordSize == sizeof(SAMPLE_RECORD));
+}
+
+SampleRecorder::SampleRecorder(QObject *parent)
+    : QObject(parent)
+    , m_file(this)          // moves to the recording thread along with us
+    , m_header(nullptr)
+    , m_records(nullptr)
+    , m_count(0)
+    , m_capacity(0)
+{
+}
+
+SampleRecorder::~SampleRecorder()
+{
+    close();
+}
+
+bool SampleRecorder::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "cannot open recording" << fileName << m_file.errorString();
+        return false;
+    }
+    RECORDING_HEADER h;
+    bool resume = (m_file.size() >= qint64(sizeof(h)))
+            && (m_file.read(reinterpret_cast<char *>(&h), sizeof(h)) == qint64(sizeof(h)))
+            && isValidHeader(&h)
+            && (m_file.size() >= fileSize(h.count));
+    if (resume) {
+        m_count = h.count;
+        m_capacity = quint64(m_file.size() - qint64(sizeof(h))) / sizeof(SAMPLE_RECORD);
+    } else {
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, RECORDING_MAGIC, sizeof(h.magic));
+        h.version = RECORDING_VERSION;
+        h.recordSize = sizeof(SAMPLE_RECORD);
+        h.created = QDateTime::currentMSecsSinceEpoch();
+        m_count = 0;
+        m_capacity = 0;
+        if (!m_file.resize(0) || !m_file.seek(0) || (m_file.write(reinterpret_cast<const char *>(&h), sizeof(h)) != qint64(sizeof(h)))) {
+            qWarning() << "cannot write recording" << fileName << m_file.errorString();
+            m_file.close();
+            return false;
+        }
+        m_file.flush();
+    }
+    if (!map(qMax(m_capacity, m_count + RECORDER_CHUNK_RECORDS))) {
+        m_file.close();
+        return false;
+    }
+    qInfo().nospace() << "recording to " << fileName << (resume ? ", continuing after " : ", ")
+                      << m_count << " samples";
+    return true;
+}
+
+void SampleRecorder::close()
+{
+    if (!m_file.isOpen())
+        return;
+    // drop the preallocated space, the closed file holds committed records only
+    if (m_header)
+        m_header->capacity = m_count;
+    unmap();
+    m_file.resize(fileSize(m_count));
+    m_file.close();
+    qInfo().nospace() << "recording " << m_file.fileName() << " closed, " << m_count << " samples";
+}
+
+void SampleRecorder::append(const SAMPLE &x)
+{
+    if (!m_header)
+        return;
+    if ((m_count >= m_capacity) && !map(m_capacity + RECORDER_CHUNK_RECORDS)) {
+        qWarning() << "recording stopped, cannot grow" << m_file.fileName();
+        close();
+        return;
+    }
+    SAMPLE_RECORD &r = m_records[m_count];
+    r.timestamp = x.timestamp;
+    r.voltage = x.voltage;
+    r.current = x.current;
+    r.power = x.power;
+    r.setVoltage = x.setVoltage;
+    r.setCurrent = x.setCurrent;
+    r.flags = x.on ? RECORD_OUTPUT_ON : 0;
+    r.reserved = 0;
+    // readers must never see the new count before the record itself
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->count = ++m_count;
+}
+
+bool SampleRecorder::map(quint64 capacity)
+{
+    // a file must not be resized while it is mapped on all platforms
+    unmap();
+    if ((m_file.size() < fileSize(capacity)) && !m_file.resize(fileSize(capacity))) {
+        qWarning() << "cannot resize recording" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    uchar *p = m_file.map(0, fileSize(capacity));
+    if (!p) {
+        qWarning() << "cannot map recording" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    m_header = reinterpret_cast<RECORDING_HEADER *>(p);
+    m_records = reinterpret_cast<SAMPLE_RECORD *>(p + sizeof(RECORDING_HEADER));
+    m_capacity = capacity;
+    m_header->capacity = capacity;
+    return true;
+}
+
+void SampleRecorder::unmap()
+{
+    if (m_header)
+        m_file.unmap(reinterpret_cast<uchar *>(m_header));
+    m_header = nullptr;
+    m_records = nullptr;
+}
+
+
+RecordingReader::RecordingReader()
+    : m_header(nullptr)
+    , m_records(nullptr)
+    , m_capacity(0)
+{
+}
+
+RecordingReader::~RecordingReader()
+{
+    close();
+}
+
+bool RecordingReader::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "cannot open recording" << fileName << m_file.errorString();
+        return false;
+    }
+    if (!map() || !isValidHeader(m_header)) {
+        qWarning() << fileName << "is not a DP700 recording";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void RecordingReader::close()
+{
+    if (m_header)
+        m_file.unmap(const_cast<uchar *>(reinterpret_cast<const uchar *>(m_header)));
+    m_header = nullptr;
+    m_records = nullptr;
+    m_capacity = 0;
+    m_file.close();
+}
+
+quint64 RecordingReader::count()
+{
+    if (!m_header)
+        return 0;
+    quint64 n = *static_cast<const volatile quint64 *>(&m_header->count);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if ((n > m_capacity) && (!map() || (n > m_capacity)))
+        n = m_capacity;
+    return n;
+}
+
+bool RecordingReader::map()
+{
+    qint64 size = m_file.size();
+    if (size < qint64(sizeof(RECORDING_HEADER)))
+        return false;
+    if (m_header)
+        m_file.unmap(const_cast<uchar *>(reinterpret_cast<const uchar *>(m_header)));
+    m_header = nullptr;
+    m_records = nullptr;
+    m_capacity = 0;
+    const uchar *p = m_file.map(0, size);
+    if (!p)
+        return false;
+    m_header = reinterpret_cast<const RECORDING_HEADER *>(p);
+    m_records = reinterpret_cast<const SAMPLE_RECORD *>(p + sizeof(RECORDING_HEADER));
+    m_capacity = quint64(size - qint64(sizeof(RECORDING_HEADER))) / sizeof(SAMPLE_RECORD);
+    return true;
+}
@@ -0,0 +1,109 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// samplerecorder.h
+// binary memory mapped sample recording, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef SAMPLERECORDER_H
+#define SAMPLERECORDER_H
+
+#include <QObject>
+#include <QFile>
+#include "sample.h"
+
+// file layout: one RECORDING_HEADER followed by count SAMPLE_RECORDs,
+// all values in host byte order. The file grows in chunks of
+// RECORDER_CHUNK_RECORDS, the space behind the last committed record is
+// preallocated. A record is complete before count includes it, so a
+// reader mapping the same file sees whole records only.
+#define RECORDING_MAGIC         "DP700REC"
+#define RECORDING_VERSION       1
+#define RECORDER_CHUNK_RECORDS  65536
+
+// SAMPLE_RECORD::flags
+#define RECORD_OUTPUT_ON        0x00000001
+
+typedef struct {
+    char    magic[8];       // RECORDING_MAGIC, not terminated
+    quint32 version;
+    quint32 recordSize;     // sizeof(SAMPLE_RECORD) of the writer
+    quint64 count;          // committed records
+    quint64 capacity;       // records the file has room for
+    qint64  created;        // ms since epoch
+    quint8  reserved[24];
+} RECORDING_HEADER;
+
+typedef struct {
+    qint64  timestamp;      // ms since epoch
+    double  voltage;
+    double  current;
+    double  power;
+    double  setVoltage;
+    double  setCurrent;
+    quint32 flags;
+    quint32 reserved;
+} SAMPLE_RECORD;
+
+Q_STATIC_ASSERT(sizeof(RECORDING_HEADER) == 64);
+Q_STATIC_ASSERT(sizeof(SAMPLE_RECORD) == 56);
+
+// appends every sample to a recording, lives in the thread emitting the samples
+class SampleRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SampleRecorder(QObject *parent = nullptr);
+    ~SampleRecorder();
+
+    bool isOpen() const { return m_header != nullptr; }
+    QString fileName() const { return m_file.fileName(); }
+    quint64 count() const { return m_count; }
+
+public slots:
+    // an existing recording is continued, anything else is replaced
+    bool open(const QString &fileName);
+    void close();
+    void append(const SAMPLE &x);
+
+private:
+    bool map(quint64 capacity);
+    void unmap();
+
+    QFile               m_file;
+    RECORDING_HEADER    *m_header;      // start of the mapping
+    SAMPLE_RECORD       *m_records;
+    quint64             m_count;
+    quint64             m_capacity;
+};
+
+// read only view of a recording, may be used while it is still written
+class RecordingReader
+{
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    bool open(const QString &fileName);
+    void close();
+
+    // number of committed records, maps new chunks when the file has grown
+    quint64 count();
+    // valid up to the last count() result, until the next count() or close()
+    const SAMPLE_RECORD *records() const { return m_records; }
+
+private:
+    bool map();
+
+    QFile                   m_file;
+    const RECORDING_HEADER  *m_header;
+    const SAMPLE_RECORD     *m_records;
+    quint64                 m_capacity;     // records covered by the mapping
+};
+
+#endif // SAMPLERECORDER_H
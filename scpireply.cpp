@@ -0,0 +1,210 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// scpireply.cpp
+// allocation free parser for SCPI response messages
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "scpireply.h"
+#include <cmath>
+
+// powers of ten that are exact in a double
+static const double pow10Table[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int pow10TableMax = 22;
+
+ScpiReply::ScpiReply(const ByteView &reply, char separator)
+    : m_reply(reply.trimmed())
+    , m_pos(0)
+    , m_separator(separator)
+{
+}
+
+bool ScpiReply::atEnd() const
+{
+    return m_pos > m_reply.size() || m_reply.isEmpty();
+}
+
+int ScpiReply::fieldEnd() const
+{
+    // separators inside quoted strings do not count
+    char quote = 0;
+    for (int i=m_pos; i<m_reply.size(); ++i) {
+        char c = m_reply.at(i);
+        if (quote) {
+            if (c == quote)
+                quote = 0;
+        } else if ((c == '"') || (c == '\'')) {
+            quote = c;
+        } else if (c == m_separator) {
+            return i;
+        }
+    }
+    return m_reply.size();
+}
+
+bool ScpiReply::nextField(ByteView &x)
+{
+    if (atEnd())
+        return false;
+    int end = fieldEnd();
+    x = m_reply.mid(m_pos, end - m_pos).trimmed();
+    // step behind the separator, past the end after the last field
+    m_pos = end + 1;
+    return true;
+}
+
+bool ScpiReply::nextNumber(double &x)
+{
+    int pos = m_pos;
+    ByteView field;
+    if (nextField(field) && toNumber(field, x))
+        return true;
+    m_pos = pos;
+    return false;
+}
+
+bool ScpiReply::nextInteger(int &x)
+{
+    int pos = m_pos;
+    ByteView field;
+    if (nextField(field) && toInteger(field, x))
+        return true;
+    m_pos = pos;
+    return false;
+}
+
+bool ScpiReply::nextString(ByteView &x)
+{
+    int pos = m_pos;
+    ByteView field;
+    if (nextField(field) && (field.size() >= 2)) {
+        char quote = field.at(0);
+        if (((quote == '"') || (quote == '\'')) && (field.at(field.size()-1) == quote)) {
+            x = field.mid(1, field.size()-2);
+            return true;
+        }
+    }
+    m_pos = pos;
+    return false;
+}
+
+bool ScpiReply::nextBool(bool &x)
+{
+    int pos = m_pos;
+    ByteView field;
+    if (nextField(field) && toBool(field, x))
+        return true;
+    m_pos = pos;
+    return false;
+}
+
+bool ScpiReply::toNumber(const ByteView &field, double &x)
+{
+    const char *p = field.begin();
+    const char *end = field.end();
+    bool negative = false;
+    if ((p < end) && ((*p == '+') || (*p == '-'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+    // collect up to 19 significant digits, that still fits into 64 bits
+    quint64 mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for (; (p < end) && (*p >= '0') && (*p <= '9'); ++p) {
+        any = true;
+        if (digits < 19) {
+            mantissa = 10*mantissa + quint64(*p - '0');
+            if (mantissa)
+                ++digits;
+        } else {
+            ++exponent;
+        }
+    }
+    if ((p < end) && (*p == '.')) {
+        for (++p; (p < end) && (*p >= '0') && (*p <= '9'); ++p) {
+            any = true;
+            if (digits < 19) {
+                mantissa = 10*mantissa + quint64(*p - '0');
+                if (mantissa)
+                    ++digits;
+                --exponent;
+            }
+        }
+    }
+    if (!any)
+        return false;
+    if ((p < end) && ((*p == 'E') || (*p == 'e'))) {
+        ++p;
+        bool expNegative = false;
+        if ((p < end) && ((*p == '+') || (*p == '-'))) {
+            expNegative = (*p == '-');
+            ++p;
+        }
+        if ((p == end) || (*p < '0') || (*p > '9'))
+            return false;
+        int e = 0;
+        for (; (p < end) && (*p >= '0') && (*p <= '9'); ++p) {
+            if (e < 10000)
+                e = 10*e + (*p - '0');
+        }
+        exponent += expNegative ? -e : e;
+    }
+    if (p != end)
+        return false;
+    double value = double(mantissa);
+    if (exponent < 0) {
+        value = (-exponent <= pow10TableMax) ? value / pow10Table[-exponent] : value * std::pow(10.0, exponent);
+    } else if (exponent > 0) {
+        value = (exponent <= pow10TableMax) ? value * pow10Table[exponent] : value * std::pow(10.0, exponent);
+    }
+    x = negative ? -value : value;
+    return true;
+}
+
+bool ScpiReply::toInteger(const ByteView &field, int &x)
+{
+    const char *p = field.begin();
+    const char *end = field.end();
+    bool negative = false;
+    if ((p < end) && ((*p == '+') || (*p == '-'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p == end)
+        return false;
+    // INT_MIN has no positive counterpart
+    const qint64 limit = negative ? Q_INT64_C(2147483648) : Q_INT64_C(2147483647);
+    qint64 value = 0;
+    for (; p < end; ++p) {
+        if ((*p < '0') || (*p > '9'))
+            return false;
+        value = 10*value + (*p - '0');
+        if (value > limit)
+            return false;
+    }
+    x = int(negative ? -value : value);
+    return true;
+}
+
+bool ScpiReply::toBool(const ByteView &field, bool &x)
+{
+    if ((field == "ON") || (field == "1")) {
+        x = true;
+        return true;
+    }
+    if ((field == "OFF") || (field == "0")) {
+        x = false;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,48 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// scpireply.h
+// allocation free parser for SCPI response messages, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef SCPIREPLY_H
+#define SCPIREPLY_H
+
+#include "byteview.h"
+
+// walks through the comma separated fields of one SCPI response, e.g.
+//   ScpiReply r(reply);
+//   double v, c;
+//   if (r.nextNumber(v) && r.nextNumber(c) && r.atEnd()) ...
+// all next...() functions return false and leave the position unchanged
+// if the next field does not have the requested type
+class ScpiReply
+{
+public:
+    explicit ScpiReply(const ByteView &reply, char separator = ',');
+
+    bool atEnd() const;
+    bool nextField(ByteView &x);
+    bool nextNumber(double &x);         // NR1, NR2 and NR3
+    bool nextInteger(int &x);           // NR1
+    bool nextString(ByteView &x);       // "quoted" or 'quoted', without the quotes
+    bool nextBool(bool &x);             // ON, OFF, 1, 0
+
+    static bool toNumber(const ByteView &field, double &x);
+    static bool toInteger(const ByteView &field, int &x);
+    static bool toBool(const ByteView &field, bool &x);
+
+private:
+    int fieldEnd() const;
+
+    ByteView    m_reply;
+    int         m_pos;
+    char        m_separator;
+};
+
+#endif // SCPIREPLY_H
@@ -14,41 +14,161 @@
 #include <QSerialPort>
 #include <QDebug>
 #include <QThread>
+#include <QLoggingCategory>
+#include <cstring>
+
+static Q_LOGGING_CATEGORY(lcSerDev, "serdev")
 
 SerDev::SerDev(const QString &portName, quint32 baudrate, QObject *parent) : QObject(parent)
-  , m_port(new QSerialPort(portName, this))
+  , m_portName(portName)
+  , m_baudRate(baudrate)
+  , m_port(nullptr)
+  , m_rxHead(0)
+  , m_rxTail(0)
+  , m_rxScan(0)
+  , m_rxBytes(0)
+  , m_txBytes(0)
 {
-    qDebug() << "Serdev::SerDev()";
-    m_port->setBaudRate(baudrate);
+    qCDebug(lcSerDev) << "Serdev::SerDev()";
+}
+
+void SerDev::open()
+{
+    close();
+    m_port = new QSerialPort(m_portName, this);
+    m_port->setBaudRate(m_baudRate);
     m_port->setStopBits(QSerialPort::OneStop);
     m_port->setParity(QSerialPort::NoParity);
     if (m_port->open(QSerialPort::ReadWrite)) {
-        qDebug().nospace() << qPrintable(portName) << ": serial port is open";
+        qCDebug(lcSerDev).nospace() << qPrintable(m_portName) << ": serial port is open";
         connect(m_port, &QSerialPort::readyRead, this, &SerDev::onNewData);
+        connect(m_port, &QSerialPort::errorOccurred, this, [this](QSerialPort::SerialPortError error) { onError(int(error)); });
     } else {
-        qDebug().nospace() << qPrintable(portName) << ": failed to open serial port";
+        qCDebug(lcSerDev).nospace() << qPrintable(m_portName) << ": failed to open serial port";
         delete m_port;
         m_port = nullptr;
     }
+    emit opened(m_port != nullptr);
+}
+
+void SerDev::close()
+{
+    if (nullptr == m_port)
+        return;
+    // a port that is gone must not report its errors again while closing
+    m_port->disconnect(this);
+    delete m_port;
+    m_port = nullptr;
+    m_rxHead = 0;
+    m_rxTail = 0;
+    m_rxScan = 0;
+    qCDebug(lcSerDev).nospace() << qPrintable(m_portName) << ": serial port is closed";
 }
 
 SerDev::~SerDev()
 {
-    qDebug() << "Serdev::~SerDev()";
+    qCDebug(lcSerDev) << "Serdev::~SerDev()";
     delete m_port;
 }
 
+quint32 SerDev::baudRate() const
+{
+    return m_baudRate;
+}
+
+bool SerDev::setBaudRate(quint32 baudrate)
+{
+    m_baudRate = baudrate;
+    if (nullptr == m_port)
+        return false;
+    return m_port->setBaudRate(baudrate);
+}
+
+void SerDev::clearBuffers()
+{
+    m_rxHead = 0;
+    m_rxTail = 0;
+    m_rxScan = 0;
+    if (nullptr != m_port)
+        m_port->clear();
+}
+
+void SerDev::clearInput()
+{
+    m_rxHead = 0;
+    m_rxTail = 0;
+    m_rxScan = 0;
+    if (nullptr != m_port)
+        m_port->clear(QSerialPort::Input);
+}
+
+void SerDev::onError(int error)
+{
+    switch (error) {
+    case QSerialPort::DeviceNotFoundError:
+    case QSerialPort::PermissionError:
+    case QSerialPort::OpenError:
+    case QSerialPort::WriteError:
+    case QSerialPort::ReadError:
+    case QSerialPort::ResourceError:
+    case QSerialPort::NotOpenError:
+        break;
+    default:
+        // timeouts and line noise, the protocol layer recovers from that
+        return;
+    }
+    QString text = m_port ? m_port->errorString() : QString();
+    qCDebug(lcSerDev).nospace() << qPrintable(m_portName) << ": " << text;
+    emit portError(text);
+}
 
 void SerDev::onNewData()
 {
-    m_rxBuffer.append(m_port->readAll());
-    decodeBuffer(m_rxBuffer);
+    while (m_port->bytesAvailable() > 0) {
+        if (m_rxTail == RX_BUFFER_SIZE) {
+            if (m_rxHead == 0) {
+                qWarning() << "receive buffer overflow, discarding" << m_rxTail << "bytes";
+                m_rxTail = 0;
+                m_rxScan = 0;
+            } else {
+                // move the incomplete line to the front to keep it contiguous
+                memmove(m_rxBuffer, m_rxBuffer + m_rxHead, size_t(m_rxTail - m_rxHead));
+                m_rxTail -= m_rxHead;
+                m_rxScan -= m_rxHead;
+                m_rxHead = 0;
+            }
+        }
+        qint64 n = m_port->read(m_rxBuffer + m_rxTail, RX_BUFFER_SIZE - m_rxTail);
+        if (n <= 0)
+            break;
+        m_rxTail += int(n);
+        m_rxBytes += quint64(n);
+        // hand out every complete line as a view into the buffer
+        const char *eol;
+        while ((m_rxScan < m_rxTail)
+               && (nullptr != (eol = static_cast<const char *>(memchr(m_rxBuffer + m_rxScan, '\n', size_t(m_rxTail - m_rxScan)))))) {
+            int start = m_rxHead;
+            int stop = int(eol - m_rxBuffer);
+            // advance first, decodeLine() may clear the buffer
+            m_rxHead = stop + 1;
+            m_rxScan = m_rxHead;
+            decodeLine(ByteView(m_rxBuffer + start, stop - start));
+        }
+        m_rxScan = m_rxTail;
+        if (m_rxHead == m_rxTail) {
+            // everything consumed, start over at the beginning
+            m_rxHead = 0;
+            m_rxTail = 0;
+            m_rxScan = 0;
+        }
+    }
 }
 
 
 void SerDev::sendData(const QByteArray &data, quint32 charDelay)
 {
     if (nullptr != m_port) {
+        m_txBytes += quint64(data.size());
         if (charDelay) {
             for (auto x : data) {
                 m_port->write(&x, 1);
@@ -60,3 +180,11 @@ void SerDev::sendData(const QByteArray &data, quint32 charDelay)
         }
     }
 }
+
+void SerDev::sendData(const char *data, int size)
+{
+    if (nullptr != m_port) {
+        m_txBytes += quint64(size);
+        m_port->write(data, size);
+    }
+}
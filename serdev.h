@@ -14,6 +14,10 @@
 #define SERDEV_H
 
 #include <QObject>
+#include "byteview.h"
+
+// receive buffer capacity, must hold the longest reply line
+#define RX_BUFFER_SIZE  4096
 
 class QSerialPort;
 
@@ -25,16 +29,46 @@ public:
     bool isValid() const { return m_port != nullptr; }
     ~SerDev();
 
+    quint32 baudRate() const;
+    bool setBaudRate(quint32 baudrate);
+    quint64 rxBytes() const { return m_rxBytes; }
+    quint64 txBytes() const { return m_txBytes; }
+
+public slots:
+    // open the port in the thread the device lives in
+    void open();
+    // closes the port, open() may be called again afterwards
+    virtual void close();
+
+signals:
+    void opened(bool ok);
+    // the port is gone or unusable, e.g. the adapter was unplugged
+    void portError(const QString &text);
+
 protected:
-    virtual void decodeBuffer(QByteArray &buffer) = 0;
+    // called for every complete line, without the terminating '\n'
+    virtual void decodeLine(const ByteView &line) = 0;
     void sendData(const QByteArray &data, quint32 charDelay = 0);
+    void sendData(const char *data, int size);
+    void clearBuffers();
+    // drops received data only, anything not yet sent still goes out
+    void clearInput();
 
 private slots:
     void onNewData();
+    void onError(int error);
 
 private:
+    QString         m_portName;
+    quint32         m_baudRate;
     QSerialPort     *m_port;
-    QByteArray      m_rxBuffer;
+    // fixed receive buffer, lines are framed in place between head and tail
+    char            m_rxBuffer[RX_BUFFER_SIZE];
+    int             m_rxHead;       // start of the first incomplete line
+    int             m_rxTail;       // end of received data
+    int             m_rxScan;       // searched for '\n' up to here
+    quint64         m_rxBytes;
+    quint64         m_txBytes;
 
 };
 
@@ -0,0 +1,306 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// dp700sim.cpp
+// DP700 instrument simulator on a Linux pseudo terminal
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "dp700sim.h"
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QFile>
+#include <QDebug>
+#include <cmath>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+// limits of the simulated DP712
+#define MAX_VOLTAGE     50.0
+#define MAX_CURRENT     3.0
+
+static const char idnReply[] = "RIGOL TECHNOLOGIES,DP712,DP7A000000000,00.01.14";
+static const char versionReply[] = "1999.0";
+
+DP700Sim::CONFIG DP700Sim::defaultConfig()
+{
+    CONFIG cfg;
+    cfg.baudrate = 9600;
+    cfg.hostBaudrate = 0;
+    cfg.latencyMs = 5;
+    cfg.jitterMs = 0;
+    cfg.dropRate = 0;
+    cfg.compound = true;
+    cfg.loadOhms = 10;
+    cfg.seed = 1;
+    return cfg;
+}
+
+DP700Sim::DP700Sim(const CONFIG &cfg, QObject *parent)
+    : QObject(parent)
+    , m_cfg(cfg)
+    , m_byteNs(cfg.baudrate ? 10 * Q_INT64_C(1000000000) / cfg.baudrate : 0)    // 8N1: 10 bits per character
+    , m_master(-1)
+    , m_slave(-1)
+    , m_notifier(nullptr)
+    , m_timer(new QTimer(this))
+    , m_rng(cfg.seed)
+    , m_rxFreeNs(0)
+    , m_txFreeNs(0)
+    , m_messages(0)
+    , m_setVoltage(0)
+    , m_setCurrent(MAX_CURRENT)
+    , m_on(false)
+{
+    m_clock.start();
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &DP700Sim::onTimer);
+}
+
+DP700Sim::~DP700Sim()
+{
+    if (!m_link.isEmpty())
+        QFile::remove(m_link);
+    if (m_slave >= 0)
+        ::close(m_slave);
+    if (m_master >= 0)
+        ::close(m_master);
+}
+
+bool DP700Sim::open(const QString &link)
+{
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((m_master < 0) || grantpt(m_master) || unlockpt(m_master)) {
+        qCritical() << "cannot create pseudo terminal";
+        return false;
+    }
+    m_slaveName = QString::fromLocal8Bit(ptsname(m_master));
+    m_slave = ::open(ptsname(m_master), O_RDWR | O_NOCTTY);
+    if (m_slave < 0) {
+        qCritical() << "cannot open" << m_slaveName;
+        return false;
+    }
+    // no echo, no line editing, until the host sets up the port itself
+    struct termios t;
+    tcgetattr(m_slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(m_slave, TCSANOW, &t);
+    fcntl(m_master, F_SETFL, fcntl(m_master, F_GETFL) | O_NONBLOCK);
+
+    if (!link.isEmpty()) {
+        QFile::remove(link);
+        if (QFile::link(m_slaveName, link))
+            m_link = link;
+        else
+            qWarning() << "cannot create link" << link;
+    }
+    m_notifier = new QSocketNotifier(m_master, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DP700Sim::onReadable);
+    return true;
+}
+
+void DP700Sim::onReadable()
+{
+    char buffer[512];
+    ssize_t n;
+    while ((n = ::read(m_master, buffer, sizeof(buffer))) > 0) {
+        qint64 now = m_clock.nsecsElapsed();
+        for (ssize_t i=0; i<n; ++i) {
+            // every character occupies the line for one character time
+            m_rxFreeNs = qMax(m_rxFreeNs, now) + m_byteNs;
+            if (buffer[i] == '\n') {
+                handleMessage(m_rxLine, m_rxFreeNs);
+                m_rxLine.clear();
+            } else if (buffer[i] != '\r') {
+                m_rxLine.append(buffer[i]);
+            }
+        }
+    }
+    schedule();
+}
+
+void DP700Sim::handleMessage(const QByteArray &msg, qint64 readyNs)
+{
+    ++m_messages;
+    if (!hostSpeedMatches()) {
+        // at the wrong baud rate the instrument sees garbage and stays silent
+        return;
+    }
+    QList<QByteArray> cmds = msg.split(';');
+    if ((cmds.size() > 1) && !m_cfg.compound) {
+        m_errors.enqueue("-113,\"Undefined header\"");
+        return;
+    }
+    QByteArray reply;
+    for (const QByteArray &cmd : cmds) {
+        QByteArray r;
+        if (execute(cmd.trimmed(), r)) {
+            if (!reply.isEmpty())
+                reply.append(';');
+            reply.append(r);
+        }
+    }
+    if (reply.isEmpty())
+        return;
+    reply.append('\n');
+    double latency = m_cfg.latencyMs;
+    if (m_cfg.jitterMs > 0)
+        latency += (2 * m_rng.generateDouble() - 1) * m_cfg.jitterMs;
+    REPLY r;
+    // replies leave in order, a short latency never overtakes a long one
+    r.dueNs = readyNs + qint64(qMax(0.0, latency) * 1e6);
+    if (!m_replies.isEmpty())
+        r.dueNs = qMax(r.dueNs, m_replies.last().dueNs);
+    r.data = reply;
+    m_replies.enqueue(r);
+}
+
+bool DP700Sim::execute(const QByteArray &cmd, QByteArray &reply)
+{
+    QByteArray header = cmd;
+    QByteArray args;
+    int space = cmd.indexOf(' ');
+    if (space >= 0) {
+        header = cmd.left(space);
+        args = cmd.mid(space+1).trimmed();
+    }
+    header = header.toUpper();
+    if (header.startsWith(':'))
+        header = header.mid(1);
+    QList<QByteArray> params = args.isEmpty() ? QList<QByteArray>() : args.split(',');
+    // the channel parameter is optional, there is only one
+    if (!params.isEmpty() && (params.first().trimmed().toUpper() == "CH1"))
+        params.removeFirst();
+
+    if (header == "*IDN?") {
+        reply = idnReply;
+    } else if (header == "SYST:VERS?") {
+        reply = versionReply;
+    } else if (header == "*OPC?") {
+        reply = "1";
+    } else if (header == "*CLS") {
+        m_errors.clear();
+        return false;
+    } else if (header == "MEAS:ALL?") {
+        double v, c;
+        measure(v, c);
+        reply = QByteArray::number(v, 'f', 2) + "," + QByteArray::number(c, 'f', 3) + "," + QByteArray::number(v*c, 'f', 3);
+    } else if (header == "OUTP:STAT?") {
+        reply = m_on ? "ON" : "OFF";
+    } else if (header == "OUTP:STAT") {
+        QByteArray state = params.isEmpty() ? QByteArray() : params.first().trimmed().toUpper();
+        if ((state == "ON") || (state == "1"))
+            m_on = true;
+        else if ((state == "OFF") || (state == "0"))
+            m_on = false;
+        else
+            m_errors.enqueue("-224,\"Illegal parameter value\"");
+        return false;
+    } else if (header == "APPL?") {
+        reply = QByteArray::number(m_setVoltage, 'f', 2) + "," + QByteArray::number(m_setCurrent, 'f', 3);
+    } else if (header == "APPL") {
+        bool okV = false, okC = true;
+        double v = params.size() > 0 ? params.at(0).trimmed().toDouble(&okV) : 0;
+        double c = m_setCurrent;
+        if (params.size() > 1)
+            c = params.at(1).trimmed().toDouble(&okC);
+        if (okV && okC && (v >= 0) && (v <= MAX_VOLTAGE) && (c >= 0) && (c <= MAX_CURRENT)) {
+            m_setVoltage = v;
+            m_setCurrent = c;
+        } else {
+            m_errors.enqueue("-222,\"Data out of range\"");
+        }
+        return false;
+    } else if (header == "SYST:ERR?") {
+        reply = m_errors.isEmpty() ? QByteArray("0,\"No error\"") : m_errors.dequeue();
+    } else {
+        m_errors.enqueue("-113,\"Undefined header\"");
+        return false;
+    }
+    return true;
+}
+
+void DP700Sim::measure(double &v, double &c) const
+{
+    // resistive load, the supply changes from constant voltage to constant current
+    if (!m_on || (m_cfg.loadOhms <= 0)) {
+        v = 0;
+        c = 0;
+        return;
+    }
+    v = m_setVoltage;
+    c = v / m_cfg.loadOhms;
+    if (c > m_setCurrent) {
+        c = m_setCurrent;
+        v = c * m_cfg.loadOhms;
+    }
+}
+
+bool DP700Sim::hostSpeedMatches() const
+{
+    if (m_cfg.hostBaudrate == 0)
+        return true;
+    static const struct {
+        speed_t     speed;
+        quint32     baudrate;
+    } speeds[] = {
+        { B4800, 4800 }, { B9600, 9600 }, { B19200, 19200 },
+        { B38400, 38400 }, { B57600, 57600 }, { B115200, 115200 }
+    };
+    struct termios t;
+    if (tcgetattr(m_slave, &t))
+        return false;
+    speed_t speed = cfgetospeed(&t);
+    for (const auto &s : speeds) {
+        if (s.speed == speed)
+            return s.baudrate == m_cfg.hostBaudrate;
+    }
+    return false;
+}
+
+void DP700Sim::onTimer()
+{
+    qint64 now = m_clock.nsecsElapsed();
+    while (!m_replies.isEmpty() && (m_replies.head().dueNs <= now)) {
+        if (m_tx.isEmpty())
+            m_txFreeNs = qMax(m_txFreeNs, m_replies.head().dueNs);
+        m_tx.append(m_replies.dequeue().data);
+    }
+    if (!m_tx.isEmpty() && (m_txFreeNs <= now)) {
+        // all characters whose transfer time has passed leave at once
+        int n = m_tx.size();
+        if (m_byteNs)
+            n = int(qMin(qint64(n), (now - m_txFreeNs) / m_byteNs + 1));
+        QByteArray out;
+        out.reserve(n);
+        for (int i=0; i<n; ++i) {
+            if ((m_cfg.dropRate <= 0) || (m_rng.generateDouble() >= m_cfg.dropRate))
+                out.append(m_tx.at(i));
+        }
+        if (!out.isEmpty() && (::write(m_master, out.constData(), size_t(out.size())) < 0))
+            qWarning() << "write to pseudo terminal failed";
+        m_tx.remove(0, n);
+        m_txFreeNs += n * m_byteNs;
+    }
+    schedule();
+}
+
+void DP700Sim::schedule()
+{
+    qint64 next = -1;
+    if (!m_tx.isEmpty())
+        next = m_txFreeNs;
+    else if (!m_replies.isEmpty())
+        next = m_replies.head().dueNs;
+    if (next < 0)
+        return;
+    qint64 delayNs = next - m_clock.nsecsElapsed();
+    m_timer->start(delayNs > 0 ? int((delayNs + 999999) / 1000000) : 0);
+}
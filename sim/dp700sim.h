@@ -0,0 +1,88 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// dp700sim.h
+// DP700 instrument simulator on a Linux pseudo terminal, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef DP700SIM_H
+#define DP700SIM_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QRandomGenerator>
+
+class QSocketNotifier;
+class QTimer;
+
+class DP700Sim : public QObject
+{
+    Q_OBJECT
+public:
+    typedef struct {
+        quint32 baudrate;       // emulated line speed, 0: no transfer delay
+        quint32 hostBaudrate;   // the host must use this baud rate, 0: accept any
+        double  latencyMs;      // instrument processing time per message
+        double  jitterMs;       // +/- uniformly distributed on top of the latency
+        double  dropRate;       // probability to lose a reply byte
+        bool    compound;       // accept ';' joined program messages
+        double  loadOhms;       // resistive load at the output
+        quint32 seed;
+    } CONFIG;
+
+    static CONFIG defaultConfig();
+
+    explicit DP700Sim(const CONFIG &cfg, QObject *parent = nullptr);
+    ~DP700Sim();
+
+    // create the pseudo terminal, optionally with a symlink to its slave side
+    bool open(const QString &link = QString());
+    QString portName() const { return m_slaveName; }
+    quint64 messages() const { return m_messages; }
+
+private slots:
+    void onReadable();
+    void onTimer();
+
+private:
+    typedef struct {
+        qint64      dueNs;
+        QByteArray  data;
+    } REPLY;
+
+    void handleMessage(const QByteArray &msg, qint64 readyNs);
+    bool execute(const QByteArray &cmd, QByteArray &reply);
+    bool hostSpeedMatches() const;
+    void measure(double &v, double &c) const;
+    void schedule();
+
+    CONFIG          m_cfg;
+    qint64          m_byteNs;           // time of one character on the line
+    int             m_master;
+    int             m_slave;            // kept open, the master reports EIO without any slave
+    QString         m_slaveName;
+    QString         m_link;
+    QSocketNotifier *m_notifier;
+    QTimer          *m_timer;
+    QElapsedTimer   m_clock;
+    QRandomGenerator m_rng;
+    QByteArray      m_rxLine;
+    qint64          m_rxFreeNs;         // emulated end of the last received character
+    QQueue<REPLY>   m_replies;          // processed messages, waiting for their due time
+    QByteArray      m_tx;
+    qint64          m_txFreeNs;         // emulated end of the last sent character
+    quint64         m_messages;
+    // instrument state
+    double          m_setVoltage;
+    double          m_setCurrent;
+    bool            m_on;
+    QQueue<QByteArray> m_errors;
+};
+
+#endif // DP700SIM_H
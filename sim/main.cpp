@@ -0,0 +1,55 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// main.cpp
+// DP700 instrument simulator entry point
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <cstdio>
+#include "dp700sim.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("dp700sim");
+
+    DP700Sim::CONFIG cfg = DP700Sim::defaultConfig();
+    QCommandLineParser parser;
+    parser.setApplicationDescription("DP700 simulator on a pseudo terminal, prints the port name to stdout");
+    parser.addHelpOption();
+    QCommandLineOption baudOption("baud", "emulated line speed, 0: no transfer delay", "rate", QString::number(cfg.baudrate));
+    QCommandLineOption hostBaudOption("host-baud", "only answer if the host uses this baud rate", "rate", "0");
+    QCommandLineOption latencyOption("latency", "reply latency", "ms", QString::number(cfg.latencyMs));
+    QCommandLineOption jitterOption("jitter", "reply latency jitter", "ms", QString::number(cfg.jitterMs));
+    QCommandLineOption dropOption("drop", "probability to lose a reply byte", "p", QString::number(cfg.dropRate));
+    QCommandLineOption noCompoundOption("no-compound", "reject ';' joined program messages");
+    QCommandLineOption loadOption("load", "resistive load", "ohms", QString::number(cfg.loadOhms));
+    QCommandLineOption seedOption("seed", "random seed", "n", QString::number(cfg.seed));
+    QCommandLineOption linkOption("link", "create a symlink to the port", "path");
+    parser.addOptions(QList<QCommandLineOption>() << baudOption << hostBaudOption << latencyOption << jitterOption
+                      << dropOption << noCompoundOption << loadOption << seedOption << linkOption);
+    parser.process(a);
+
+    cfg.baudrate = parser.value(baudOption).toUInt();
+    cfg.hostBaudrate = parser.value(hostBaudOption).toUInt();
+    cfg.latencyMs = parser.value(latencyOption).toDouble();
+    cfg.jitterMs = parser.value(jitterOption).toDouble();
+    cfg.dropRate = parser.value(dropOption).toDouble();
+    cfg.compound = !parser.isSet(noCompoundOption);
+    cfg.loadOhms = parser.value(loadOption).toDouble();
+    cfg.seed = parser.value(seedOption).toUInt();
+
+    DP700Sim sim(cfg);
+    if (!sim.open(parser.value(linkOption)))
+        return 1;
+    fprintf(stdout, "%s\n", qPrintable(sim.portName()));
+    fflush(stdout);
+    return a.exec();
+}
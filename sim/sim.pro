@@ -0,0 +1,16 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = dp700sim
+
+# pseudo terminals are Linux only
+!linux: error("the DP700 simulator needs Linux pseudo terminals")
+
+SOURCES += \
+    main.cpp \
+    dp700sim.cpp
+
+HEADERS += \
+    dp700sim.h
@@ -0,0 +1,89 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogrecord.h, header file
+// structured log record, formatted only when it is shown or written
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#ifndef TLOGRECORD_H
+#define TLOGRECORD_H
+
+#include <QString>
+#include <QDateTime>
+#include <QMetaType>
+#include <QLoggingCategory>
+#include <cstring>
+
+typedef struct {
+    QtMsgType   type;
+    const char  *category;      // name of a QLoggingCategory, they live as long as the program
+    QString     text;           // message only, without time, level and category
+    int         repeat;         // number of identical messages collated into this one
+    qint64      firstTime;      // ms since epoch
+    qint64      lastTime;
+} TLOG_RECORD;
+
+Q_DECLARE_METATYPE(TLOG_RECORD)
+
+// fixed width level names used in all log outputs
+inline const char *tLogLevelName(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:    return "DBUG";
+    case QtInfoMsg:     return "INFO";
+    case QtWarningMsg:  return "WARN";
+    case QtCriticalMsg: return "CRIT";
+    case QtFatalMsg:    return "FATL";
+    }
+    return "????";
+}
+
+// "[yyyy-MM-dd hh:mm:ss.zzz]"
+inline QString tLogTimeTag(qint64 msecsSinceEpoch)
+{
+    return QDateTime::fromMSecsSinceEpoch(msecsSinceEpoch).toString("[yyyy-MM-dd hh:mm:ss.zzz]");
+}
+
+// true if the category name is worth showing, plain qDebug() etc. use "default"
+inline bool tLogHasCategory(const char *category)
+{
+    return category && *category && strcmp(category, "default");
+}
+
+// "LEVL category: text (repeated ...)", everything but the time tag
+inline QString tLogText(const TLOG_RECORD &r)
+{
+    QString line = QLatin1String(tLogLevelName(r.type)) + ' ';
+    if (tLogHasCategory(r.category))
+        line += QLatin1String(r.category) + QLatin1String(": ");
+    line += r.text;
+    if (r.repeat > 1) {
+        line += QString(" (repeated %1 times").arg(r.repeat);
+        qint64 dT = r.lastTime - r.firstTime;
+        if (dT)
+            line += QString(", within last %1 seconds)").arg(dT / 1000.0, 0, 'f', 1);
+        else
+            line += ")";
+    }
+    return line;
+}
+
+// installs the category filter rules, separated by ';' or new lines, on top of
+// the build defaults: debug messages are rejected in release builds before any
+// of their arguments are formatted unless a rule enables them
+inline void tSetLogRules(const QString &rules)
+{
+    QString all;
+#ifndef QT_DEBUG
+    all = "*.debug=false\n";
+#endif
+    all += QString(rules).replace(';', '\n');
+    QLoggingCategory::setFilterRules(all);
+}
+
+#endif // TLOGRECORD_H
@@ -0,0 +1,201 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogwriter.cpp
+// append-only log file writer thread with rotation
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#include "tlogwriter.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <climits>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// messages written by the writer thread go to stderr only, logging them
+// through qDebug() etc. would feed them back into the queue
+
+TLogWriter::CONFIG TLogWriter::defaultConfig()
+{
+    CONFIG cfg;
+    cfg.queueSize = 4096;
+    cfg.maxBytes = 10*1024*1024;
+    cfg.maxAgeSec = 24*3600;
+    cfg.keepFiles = 5;
+    cfg.syncMs = 1000;
+    return cfg;
+}
+
+TLogWriter::TLogWriter(const QString &fileName, const CONFIG &cfg, QObject *parent)
+    : QThread(parent)
+    , m_cfg(cfg)
+    , m_fileName(fileName)
+    , m_fileOpened(0)
+    , m_fileBytes(0)
+    , m_queue(qMax(1, cfg.queueSize))
+    , m_head(0)
+    , m_count(0)
+    , m_dropped(0)
+    , m_flushRequest(0)
+    , m_flushDone(0)
+    , m_stop(false)
+{
+    setObjectName("log writer");
+}
+
+TLogWriter::~TLogWriter()
+{
+    m_lock.lock();
+    m_stop = true;
+    m_wake.wakeOne();
+    m_lock.unlock();
+    wait();
+}
+
+bool TLogWriter::enqueue(const ENTRY &entry)
+{
+    QMutexLocker lock(&m_lock);
+    if (m_count >= m_queue.size()) {
+        ++m_dropped;
+        return false;
+    }
+    // QString is implicitly shared, this copies a pointer
+    m_queue[(m_head + m_count) % m_queue.size()] = entry;
+    if (m_count++ == 0)
+        m_wake.wakeOne();
+    return true;
+}
+
+void TLogWriter::flush()
+{
+    QMutexLocker lock(&m_lock);
+    if (!isRunning())
+        return;
+    quint64 request = ++m_flushRequest;
+    m_wake.wakeOne();
+    while (m_flushDone < request)
+        m_flushed.wait(&m_lock);
+}
+
+void TLogWriter::run()
+{
+    // the previous run's log is kept as the first rotated file
+    if (QFile::exists(m_fileName) && (QFile(m_fileName).size() > 0))
+        rotate();
+    openFile();
+    QVector<ENTRY> batch;
+    batch.reserve(m_queue.size());
+    QElapsedTimer lastSync;
+    lastSync.start();
+    bool dirty = false;
+    forever {
+        m_lock.lock();
+        while (!m_count && !m_stop && (m_flushRequest == m_flushDone)) {
+            unsigned long timeout = dirty ? qMax(Q_INT64_C(1), m_cfg.syncMs - lastSync.elapsed()) : ULONG_MAX;
+            if (!m_wake.wait(&m_lock, timeout))
+                break;
+        }
+        // take everything queued so far, the producers go on while it is written
+        for (int i=0; i<m_count; ++i) {
+            ENTRY &e = m_queue[(m_head + i) % m_queue.size()];
+            batch.append(e);
+            e.text = QString();
+        }
+        m_head = (m_head + m_count) % m_queue.size();
+        m_count = 0;
+        quint64 dropped = m_dropped;
+        m_dropped = 0;
+        quint64 flushRequest = m_flushRequest;
+        bool stop = m_stop;
+        m_lock.unlock();
+
+        for (const ENTRY &e : batch)
+            write(e);
+        if (dropped) {
+            ENTRY e;
+            e.type = QtWarningMsg;
+            e.category = nullptr;
+            e.text = QString("log queue full, %1 messages dropped").arg(dropped);
+            e.repeat = 0;
+            e.lastTime = e.firstTime = QDateTime::currentMSecsSinceEpoch();
+            write(e);
+        }
+        dirty |= !batch.isEmpty() || dropped;
+        batch.resize(0);
+        if (dirty && (stop || (flushRequest != m_flushDone) || (lastSync.elapsed() >= m_cfg.syncMs))) {
+            sync();
+            dirty = false;
+            lastSync.start();
+        }
+
+        m_lock.lock();
+        m_flushDone = flushRequest;
+        m_flushed.wakeAll();
+        bool done = stop && !m_count;
+        m_lock.unlock();
+        if (done)
+            break;
+    }
+    m_file.close();
+}
+
+void TLogWriter::openFile()
+{
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QFile::WriteOnly | QFile::Append))
+        fprintf(stderr, "cannot open log file %s\n", m_fileName.toLocal8Bit().constData());
+    m_fileOpened = QDateTime::currentMSecsSinceEpoch();
+    m_fileBytes = m_file.isOpen() ? m_file.size() : 0;
+}
+
+void TLogWriter::rotate()
+{
+    if (m_file.isOpen()) {
+        sync();
+        m_file.close();
+    }
+    // <name>.<keepFiles> is dropped, all others move up by one
+    QFile::remove(QString("%1.%2").arg(m_fileName).arg(m_cfg.keepFiles));
+    for (int i=m_cfg.keepFiles-1; i>0; --i)
+        QFile::rename(QString("%1.%2").arg(m_fileName).arg(i), QString("%1.%2").arg(m_fileName).arg(i+1));
+    if (m_cfg.keepFiles > 0)
+        QFile::rename(m_fileName, m_fileName + ".1");
+    else
+        QFile::remove(m_fileName);
+}
+
+void TLogWriter::sync()
+{
+    if (!m_file.isOpen())
+        return;
+    m_file.flush();
+#ifdef Q_OS_WIN
+    _commit(m_file.handle());
+#else
+    fsync(m_file.handle());
+#endif
+}
+
+void TLogWriter::write(const ENTRY &entry)
+{
+    if (((m_cfg.maxBytes > 0) && (m_fileBytes >= m_cfg.maxBytes))
+            || ((m_cfg.maxAgeSec > 0) && (entry.lastTime - m_fileOpened >= qint64(m_cfg.maxAgeSec) * 1000))) {
+        rotate();
+        openFile();
+    }
+    if (!m_file.isOpen())
+        return;
+    QString line = tLogTimeTag(entry.lastTime) + ' ' + tLogText(entry) + '\n';
+    QByteArray data = line.toUtf8();
+    m_file.write(data);
+    m_fileBytes += data.size();
+}
@@ -0,0 +1,76 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogwriter.h, header file
+// append-only log file writer thread with rotation
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#ifndef TLOGWRITER_H
+#define TLOGWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QFile>
+#include "tlogrecord.h"
+
+class TLogWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    typedef struct {
+        int         queueSize;      // messages waiting to be written, more are dropped
+        qint64      maxBytes;       // rotate when the file gets larger, 0: never
+        int         maxAgeSec;      // rotate when the file gets older, 0: never
+        int         keepFiles;      // rotated files kept as <name>.1 ... <name>.<keepFiles>
+        int         syncMs;         // write to disk at least that often
+    } CONFIG;
+
+    // formatted in the writer thread, just before it goes to the file
+    typedef TLOG_RECORD ENTRY;
+
+    static CONFIG defaultConfig();
+
+    explicit TLogWriter(const QString &fileName, const CONFIG &cfg = defaultConfig(), QObject *parent = nullptr);
+    ~TLogWriter();
+
+    // constant time and never blocking on file I/O, false if the queue is full
+    bool enqueue(const ENTRY &entry);
+    // blocks until everything enqueued so far is on disk
+    void flush();
+
+protected:
+    void run() override;
+
+private:
+    void openFile();
+    void rotate();
+    void sync();
+    void write(const ENTRY &entry);
+
+    CONFIG          m_cfg;
+    QString         m_fileName;
+    QFile           m_file;             // used by the writer thread only
+    qint64          m_fileOpened;       // ms since epoch
+    qint64          m_fileBytes;
+
+    QMutex          m_lock;             // guards everything below
+    QWaitCondition  m_wake;
+    QWaitCondition  m_flushed;
+    QVector<ENTRY>  m_queue;            // ring of queueSize entries
+    int             m_head;
+    int             m_count;
+    quint64         m_dropped;
+    quint64         m_flushRequest;
+    quint64         m_flushDone;
+    bool            m_stop;
+};
+
+#endif // TLOGWRITER_H
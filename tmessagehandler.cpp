@@ -13,24 +13,44 @@
 
 #include "tmessagehandler.h"
 #include <QDateTime>
-#include <QFile>
-#include <QTextStream>
+#include <QThread>
 
-#define MESSAGE_LIMIT   10000
 static const int msgCollateTime = 5;   // print out identical messages after 5 seconds, latest
+// messages that may wait for the consumer, more are dropped
+#define MESSAGE_QUEUE_SIZE  4096
+// once woken up, the consumer collects messages for that long before handling them as one batch
+#define DRAIN_MS            10
+// longest time a fatal message waits for the log file
+#define FATAL_WAIT_MS       1000
 
 TMessageHandler::TMessageHandler(const QString &filename, QObject *parent)
     : QObject(parent)
+    , m_queue(MESSAGE_QUEUE_SIZE)
+    , m_dropped(0)
+    , m_posted(0)
+    , m_consumed(0)
+    , m_stop(false)
+    , m_consumer(nullptr)
     , m_filename(filename)
+    , m_writer(filename)
 {
 #ifdef QT_DEBUG
     fprintf(stderr, "+++ TMessageHandler::TMessageHandler()\n");
 #endif
     qRegisterMetaType<TMessageHandler*>("TMessageHandlerStar");
+    qRegisterMetaType<TLOG_RECORD>("TLOG_RECORD");
+    m_lastMsg.type = QtInfoMsg;
+    m_lastMsg.category = nullptr;
     m_lastMsg.text = QString();
     m_lastMsg.firstTime = QDateTime::currentMSecsSinceEpoch();
     m_lastMsg.lastTime = m_lastMsg.firstTime;
     m_lastMsg.repeat = 0;
+    m_writer.start(QThread::LowPriority);
+    m_consumer = QThread::create([this]() { consume(); });
+    m_consumer->setObjectName("message consumer");
+    // messageAdded() is emitted from the consumer thread, receivers get queued signals
+    moveToThread(m_consumer);
+    m_consumer->start();
 #ifdef QT_DEBUG
     fprintf(stderr, "--- TMessageHandler::TMessageHandler()\n");
 #endif
@@ -41,22 +61,84 @@ TMessageHandler::~TMessageHandler()
 #ifdef QT_DEBUG
     fprintf(stderr, "+++ TMessageHandler::~TMessageHandler()\n");
 #endif
-    saveMessages(m_filename);
+    // the consumer handles what is still queued before it stops
+    m_stop = true;
+    m_wakeup.release();
+    m_consumer->wait();
+    delete m_consumer;
+    // a repeated message not written yet
+    if (m_lastMsg.repeat)
+        m_writer.enqueue(m_lastMsg);
+    // m_writer writes what is left and stops when it is destroyed
 #ifdef QT_DEBUG
     fprintf(stderr, "--- TMessageHandler::~TMessageHandler()\n");
 #endif
 }
 
-void TMessageHandler::addMessage(const QString &text)
+bool TMessageHandler::post(QtMsgType type, const char *category, const QString &text)
 {
-#ifdef QT_DEBUG
-    //fprintf(stderr, "+++ TMessageHandler::addMessage()\n");
-#endif
-    MSG_ENTRY msg;
-    msg.text = text;
-    msg.lastTime = QDateTime::currentMSecsSinceEpoch();
-    msg.repeat = 0;
-    if (msg.text != m_lastMsg.text) {
+    TLOG_RECORD r;
+    r.type = type;
+    r.category = category;
+    r.text = text;
+    r.repeat = 0;
+    r.firstTime = r.lastTime = QDateTime::currentMSecsSinceEpoch();
+    if (!m_queue.push(r)) {
+        ++m_dropped;
+        m_wakeup.release();
+        return false;
+    }
+    ++m_posted;
+    m_wakeup.release();
+    return true;
+}
+
+void TMessageHandler::waitSaved()
+{
+    // never wait for ourselves, the consumer may be the thread posting
+    if (QThread::currentThread() != m_consumer) {
+        quint64 posted = m_posted;
+        for (int i=0; (i<FATAL_WAIT_MS) && (m_consumed < posted); ++i)
+            QThread::msleep(1);
+    }
+    m_writer.flush();
+}
+
+void TMessageHandler::consume()
+{
+    while (!m_stop) {
+        // nothing to do until a message is posted
+        m_wakeup.acquire();
+        QThread::msleep(DRAIN_MS);
+        // the messages of the batch woke it up once only
+        m_wakeup.tryAcquire(m_wakeup.available());
+        drain();
+    }
+    drain();
+}
+
+void TMessageHandler::drain()
+{
+    TLOG_RECORD r;
+    while (m_queue.pop(r)) {
+        addRecord(r);
+        ++m_consumed;
+    }
+    quint32 dropped = m_dropped.exchange(0);
+    if (dropped) {
+        r.type = QtWarningMsg;
+        r.category = nullptr;
+        r.text = QString("message queue full, %1 messages dropped").arg(dropped);
+        r.repeat = 0;
+        r.firstTime = r.lastTime = QDateTime::currentMSecsSinceEpoch();
+        addRecord(r);
+    }
+}
+
+void TMessageHandler::addRecord(const TLOG_RECORD &msg)
+{
+    if ((msg.type != m_lastMsg.type) || (qstrcmp(msg.category, m_lastMsg.category) != 0)
+            || (msg.text != m_lastMsg.text)) {
         //this is a new message
         if (m_lastMsg.repeat)
             append(m_lastMsg);
@@ -73,48 +155,22 @@ void TMessageHandler::addMessage(const QString &text)
             m_lastMsg.firstTime = m_lastMsg.lastTime;
         }
     }
-#ifdef QT_DEBUG
-    //fprintf(stderr, "--- TMessageHandler::addMessage()\n");
-#endif
 }
 
-void TMessageHandler::saveMessages(const QString &fileName)
+void TMessageHandler::saveMessages()
 {
 #ifdef QT_DEBUG
-    fprintf(stderr, "+++ TMessageHandler::saveMessages(fileName=\"%s\")\n", fileName.toLocal8Bit().constData());
-#endif
-    if (m_msg.size()) {
-        QFile f(fileName);
-        if (f.open(QFile::WriteOnly | QFile::Truncate)) {
-            QTextStream t(&f);
-            for(MSG_ENTRY &msg : m_msg) {
-                t << QDateTime::fromMSecsSinceEpoch(msg.lastTime).toString("[yyyy-MM-dd hh:mm:ss.zzz] ") + msg.text;
-                if (msg.repeat > 1) {
-                    t << " (repeated " << msg.repeat << " times";
-                    uint dT = msg.lastTime - msg.firstTime;
-                    if (dT)
-                        t << ", within last " << dT << " seconds)";
-                    else
-                        t << ")";
-                }
-                t << Qt::endl;
-            }
-            f.close();
-            emit messageSaved();
-#ifdef QT_DEBUG
-            fprintf(stderr, "    TMessageHandler::saveMessages(): messageSaved!\n");
+    fprintf(stderr, "+++ TMessageHandler::saveMessages()\n");
 #endif
-        }
-    }
+    m_writer.flush();
+    emit messageSaved();
 #ifdef QT_DEBUG
     fprintf(stderr, "--- TMessageHandler::saveMessages()\n");
 #endif
 }
 
-void TMessageHandler::append(const MSG_ENTRY &msg)
+void TMessageHandler::append(const TLOG_RECORD &msg)
 {
-    if (m_msg.size() >= MESSAGE_LIMIT)
-        m_msg.removeFirst();
-    m_msg.append(msg);
-    emit messageAdded(msg.text);
+    m_writer.enqueue(msg);
+    emit messageAdded(msg);
 }
@@ -22,6 +22,13 @@
 #include <QMetaType>
 #include <QStringList>
 #include <QDateTime>
+#include <QSemaphore>
+#include <atomic>
+#include "tlogrecord.h"
+#include "tlogwriter.h"
+#include "tmpscqueue.h"
+
+class QThread;
 
 class TMessageHandler : public QObject
 {
@@ -31,29 +38,38 @@ public:
     explicit TMessageHandler(const QString &filename, QObject *parent = nullptr);
     ~TMessageHandler();
 
+    // may be called from any thread, never blocks, false if the queue is full
+    // the record is formatted only when it is displayed or written
+    bool post(QtMsgType type, const char *category, const QString &text);
+    // waits a moment for the posted messages to reach the disk
+    void waitSaved();
+
 public slots:
-    void addMessage(const QString &text);
-    void saveMessages(const QString &fileName);
+    // blocks until all messages are on disk
+    void saveMessages();
 
 signals:
-    void messageAdded(const QString &msg);
+    void messageAdded(const TLOG_RECORD &msg);
     void messageSaved();
 
 private:
-    typedef struct
-    {
-        QString     text;
-        int         repeat;
-        qint64      firstTime;
-        qint64      lastTime;
-    } MSG_ENTRY;
+    TLOG_RECORD         m_lastMsg;
 
-    QList<MSG_ENTRY>    m_msg;
-    MSG_ENTRY           m_lastMsg;
+    void addRecord(const TLOG_RECORD &msg);
+    void append(const TLOG_RECORD &msg);
+    void consume();
+    void drain();
 
-    void append(const MSG_ENTRY &msg);
+    TMpscQueue<TLOG_RECORD> m_queue;
+    std::atomic<quint32>    m_dropped;
+    std::atomic<quint64>    m_posted;
+    std::atomic<quint64>    m_consumed;
+    std::atomic<bool>       m_stop;
+    QSemaphore              m_wakeup;       // released by post(), the consumer sleeps on it
+    QThread                 *m_consumer;
 
     QString         m_filename;
+    TLogWriter      m_writer;       // appends every message to m_filename in the background
 };
 
 Q_DECLARE_METATYPE(TMessageHandler*)
@@ -0,0 +1,100 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tmpscqueue.h, header file
+// bounded lock-free multi producer, single consumer queue
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#ifndef TMPSCQUEUE_H
+#define TMPSCQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+// Every cell carries a sequence number telling whether it is free for the
+// producer claiming position pos (seq == pos) or holds the value written
+// for it (seq == pos + 1). Producers claim positions with a compare and
+// swap and never wait for each other or for the consumer; a full queue
+// makes push() fail instead. Only one thread may call pop().
+template <typename T>
+class TMpscQueue
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit TMpscQueue(quint32 capacity)
+        : m_mask(roundUp(capacity) - 1)
+        , m_cells(new CELL[m_mask + 1])
+        , m_pushPos(0)
+        , m_popPos(0)
+    {
+        for (quint32 i=0; i<=m_mask; ++i)
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // any thread, lock-free
+    bool push(const T &x)
+    {
+        quint32 pos = m_pushPos.load(std::memory_order_relaxed);
+        CELL *cell;
+        forever {
+            cell = &m_cells[pos & m_mask];
+            qint32 diff = qint32(cell->seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                // the consumer has not taken the value of the previous round yet
+                return false;
+            } else {
+                pos = m_pushPos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = x;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer thread only
+    bool pop(T &x)
+    {
+        CELL *cell = &m_cells[m_popPos & m_mask];
+        if (cell->seq.load(std::memory_order_acquire) != m_popPos + 1)
+            return false;
+        x = std::move(cell->value);
+        cell->value = T();
+        cell->seq.store(m_popPos + m_mask + 1, std::memory_order_release);
+        ++m_popPos;
+        return true;
+    }
+
+private:
+    typedef struct {
+        std::atomic<quint32>    seq;
+        T                       value;
+    } CELL;
+
+    static quint32 roundUp(quint32 x)
+    {
+        quint32 n = 2;
+        while (n < x)
+            n <<= 1;
+        return n;
+    }
+
+    const quint32           m_mask;
+    std::unique_ptr<CELL[]> m_cells;
+    // keep producers and consumer off each other's cache line
+    char                    m_pad0[64];
+    std::atomic<quint32>    m_pushPos;
+    char                    m_pad1[64];
+    quint32                 m_popPos;
+};
+
+#endif // TMPSCQUEUE_H
@@ -14,69 +14,62 @@
 #define TMSGHANDLER_MAIN_H
 
 #include "tmessagehandler.h"
+#include <QThread>
+#include <atomic>
 
 #define T_INSTALL_MSGHANDLER(filename) {               \
     pTMsgHandler = new TMessageHandler(filename); \
     qInstallMessageHandler(_TMessageHandler);          \
     }
 
+// threads may still log while the handler is removed: new messages go to
+// stdout/stderr, the handler is deleted when no thread is posting to it anymore
 #define T_REMOVE_MSGHANDLER() {                        \
-    delete pTMsgHandler;                               \
+    TMessageHandler *h = pTMsgHandler.exchange(nullptr); \
+    while (tMsgHandlerUsers > 0)                       \
+        QThread::yieldCurrentThread();                 \
+    delete h;                                          \
     }
 
-static TMessageHandler *pTMsgHandler = nullptr;
+static std::atomic<TMessageHandler *> pTMsgHandler(nullptr);
+// threads in _TMessageHandler() that may have seen pTMsgHandler set
+static std::atomic<int> tMsgHandlerUsers(0);
 
+// called from any thread, only for messages whose category is enabled: the
+// message is posted to the handler's lock-free queue as a record, time tag,
+// level and category are formatted later when it is written or displayed
 void _TMessageHandler(QtMsgType t, const QMessageLogContext &context, const QString &msg)
 {
-    Q_UNUSED(context)
-    QString tag = QDateTime::currentDateTime().toString("[yyyy-MM-dd hh:mm:ss.zzz] ");
-    if (pTMsgHandler) {
-        switch (t) {
-        case QtDebugMsg:
-#ifdef QT_DEBUG
-            pTMsgHandler->addMessage(tag + "DBUG " + msg);
-#endif
-            break;
-        case QtInfoMsg:
-            pTMsgHandler->addMessage(tag + "INFO " + msg);
-            break;
-        case QtWarningMsg:
-            pTMsgHandler->addMessage(tag + "WARN " + msg);
-            break;
-        case QtCriticalMsg:
-            pTMsgHandler->addMessage(tag + "CRIT " + msg);
-            break;
-        case QtFatalMsg:
-            pTMsgHandler->addMessage(tag + "FATL " + msg);
+    // counted before the handler is read, T_REMOVE_MSGHANDLER() waits for that
+    ++tMsgHandlerUsers;
+    TMessageHandler *handler = pTMsgHandler;
+    if (handler) {
+        handler->post(t, context.category, msg);
+        if (t == QtFatalMsg) {
+            // give the message a chance to reach the log file
+            handler->waitSaved();
             abort();
         }
     }
+    // the handler may be deleted from here on
+    --tMsgHandlerUsers;
 #ifndef QT_DEBUG
-    else    // always print to stderr in DEBUG mode
-#endif
-    {
-        switch (t) {
-        case QtDebugMsg:
-#ifdef QT_DEBUG
-            fprintf(stdout, "%s DBUG %s\n", qPrintable(tag), qPrintable(msg));
+    // always print to stderr in DEBUG mode
+    if (handler)
+        return;
 #endif
-            break;
-        case QtInfoMsg:
-            fprintf(stdout, "%s INFO %s\n", qPrintable(tag), qPrintable(msg));
-            break;
-        case QtWarningMsg:
-            fprintf(stderr, "%s WARN %s\n", qPrintable(tag), qPrintable(msg));
-            break;
-        case QtCriticalMsg:
-            fprintf(stderr, "%s CRIT %s\n", qPrintable(tag), qPrintable(msg));
-            break;
-        case QtFatalMsg:
-            fprintf(stderr, "%s FATL %s\n", qPrintable(tag), qPrintable(msg));
-            abort();
-        }
-        fflush(stdout);
-        fflush(stderr);
-    }
+    TLOG_RECORD r;
+    r.type = t;
+    r.category = context.category;
+    r.text = msg;
+    r.repeat = 0;
+    r.firstTime = r.lastTime = QDateTime::currentMSecsSinceEpoch();
+    FILE *out = ((t == QtDebugMsg) || (t == QtInfoMsg)) ? stdout : stderr;
+    fprintf(out, "%s %s\n", qPrintable(tLogTimeTag(r.lastTime)), qPrintable(tLogText(r)));
+    fflush(stdout);
+    fflush(stderr);
+    if (t == QtFatalMsg)
+        abort();
 }
 
 #endif // PFMSGHANDLER_MAIN_H
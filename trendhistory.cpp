@@ -0,0 +1,111 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// trendhistory.cpp
+// sample ring with min/max level of detail pyramid
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "trendhistory.h"
+
+TrendHistory::TrendHistory()
+    : m_mask((Q_UINT64_C(1) << TREND_CAPACITY_LOG2) - 1)
+    , m_first(0)
+    , m_end(0)
+{
+    m_time.resize(int(m_mask + 1));
+    m_value.resize(int(m_mask + 1) * CHANNELS);
+    // stop while a level still has a few bins
+    for (int shift=TREND_LEVEL_LOG2; shift<=TREND_CAPACITY_LOG2-TREND_LEVEL_LOG2; shift+=TREND_LEVEL_LOG2) {
+        LEVEL l;
+        l.shift = shift;
+        l.mask = m_mask >> shift;
+        l.min.resize(int(l.mask + 1) * CHANNELS);
+        l.max.resize(int(l.mask + 1) * CHANNELS);
+        m_levels.append(l);
+    }
+}
+
+void TrendHistory::clear()
+{
+    m_first = 0;
+    m_end = 0;
+}
+
+void TrendHistory::append(const SAMPLE &x)
+{
+    const float v[CHANNELS] = { float(x.voltage), float(x.current), float(x.power) };
+    quint64 seq = m_end;
+    m_time[int(seq & m_mask)] = x.timestamp;
+    float *p = m_value.data() + int(seq & m_mask) * CHANNELS;
+    for (int c=0; c<CHANNELS; ++c)
+        p[c] = v[c];
+    for (LEVEL &l : m_levels) {
+        int bin = int((seq >> l.shift) & l.mask) * CHANNELS;
+        float *lo = l.min.data() + bin;
+        float *hi = l.max.data() + bin;
+        if ((seq & ((Q_UINT64_C(1) << l.shift) - 1)) == 0) {
+            // first sample of a new bin
+            for (int c=0; c<CHANNELS; ++c)
+                lo[c] = hi[c] = v[c];
+        } else {
+            for (int c=0; c<CHANNELS; ++c) {
+                lo[c] = qMin(lo[c], v[c]);
+                hi[c] = qMax(hi[c], v[c]);
+            }
+        }
+    }
+    ++m_end;
+    if (m_end - m_first > m_mask + 1)
+        ++m_first;
+}
+
+quint64 TrendHistory::seqAt(qint64 t) const
+{
+    quint64 lo = m_first;
+    quint64 hi = m_end;
+    while (lo < hi) {
+        quint64 mid = lo + (hi - lo) / 2;
+        if (timeAt(mid) < t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+bool TrendHistory::minMax(int channel, quint64 from, quint64 to, float &lo, float &hi) const
+{
+    from = qMax(from, m_first);
+    to = qMin(to, m_end);
+    if (from >= to)
+        return false;
+    lo = hi = valueAt(channel, from);
+    // walk from left to right, always taking the largest aligned bin inside the range
+    while (from < to) {
+        int level = -1;
+        while ((level+1 < m_levels.size())) {
+            quint64 n = Q_UINT64_C(1) << m_levels.at(level+1).shift;
+            if ((from & (n - 1)) || (from + n > to))
+                break;
+            ++level;
+        }
+        if (level < 0) {
+            float v = valueAt(channel, from);
+            lo = qMin(lo, v);
+            hi = qMax(hi, v);
+            ++from;
+        } else {
+            const LEVEL &l = m_levels.at(level);
+            int bin = int((from >> l.shift) & l.mask) * CHANNELS + channel;
+            lo = qMin(lo, l.min.at(bin));
+            hi = qMax(hi, l.max.at(bin));
+            from += Q_UINT64_C(1) << l.shift;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// trendhistory.h
+// sample ring with min/max level of detail pyramid, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef TRENDHISTORY_H
+#define TRENDHISTORY_H
+
+#include <QVector>
+#include "sample.h"
+
+// samples kept in the ring, 2^19 are 2.9 h at 50 samples per second
+#define TREND_CAPACITY_LOG2     19
+// every level combines 4 bins of the level below
+#define TREND_LEVEL_LOG2        2
+
+// Samples are addressed by a sequence number counting from the first sample
+// ever added, the ring holds the last TREND_CAPACITY of them. Level k of the
+// pyramid keeps min and max of 4^k consecutive samples, so the extremes of
+// any range are found by visiting a few bins per level, independent of the
+// range length.
+class TrendHistory
+{
+public:
+    typedef enum {
+        Voltage,
+        Current,
+        Power,
+        CHANNELS
+    } CHANNEL;
+
+    TrendHistory();
+
+    void clear();
+    void append(const SAMPLE &x);
+
+    bool isEmpty() const { return m_end == m_first; }
+    quint64 first() const { return m_first; }       // oldest sample still kept
+    quint64 end() const { return m_end; }           // behind the newest sample
+    qint64 timeAt(quint64 seq) const { return m_time.at(int(seq & m_mask)); }
+    float valueAt(int channel, quint64 seq) const { return m_value.at(int(seq & m_mask) * CHANNELS + channel); }
+    // first sample at or after time t, end() if there is none
+    quint64 seqAt(qint64 t) const;
+    // extremes of samples [from, to), false for an empty range
+    bool minMax(int channel, quint64 from, quint64 to, float &lo, float &hi) const;
+
+private:
+    typedef struct {
+        int             shift;      // log2 of the samples per bin
+        quint64         mask;       // bins in the ring - 1
+        QVector<float>  min;        // bin * CHANNELS + channel
+        QVector<float>  max;
+    } LEVEL;
+
+    QVector<qint64> m_time;
+    QVector<float>  m_value;        // level 0, seq * CHANNELS + channel
+    QVector<LEVEL>  m_levels;       // level 1 and up
+    quint64         m_mask;
+    quint64         m_first;
+    quint64         m_end;
+};
+
+#endif // TRENDHISTORY_H
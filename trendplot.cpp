@@ -0,0 +1,219 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// trendplot.cpp
+// live trend plot of voltage, current and power
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "trendplot.h"
+#include <QPainter>
+#include <QTimer>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QDateTime>
+#include <cmath>
+
+// redraw at most that often, new samples only mark the plot dirty
+#define FRAME_MS        40
+#define DEFAULT_SPAN_MS (60*1000)
+#define MIN_SPAN_MS     1000
+#define MAX_SPAN_MS     (24*3600*1000)
+#define ZOOM_STEP       1.25
+// room for the scale labels
+#define LABEL_WIDTH     56
+
+static const struct {
+    const char  *name;
+    const char  *unit;
+    QColor      color;
+} channels[TrendHistory::CHANNELS] = {
+    { "U", "V", QColor("yellow") },
+    { "I", "A", QColor("deepskyblue") },
+    { "P", "W", QColor("orange") },
+};
+
+TrendPlot::TrendPlot(QWidget *parent)
+    : QWidget(parent)
+    , m_frameTimer(new QTimer(this))
+    , m_dirty(false)
+    , m_follow(true)
+    , m_endMs(0)
+    , m_spanMs(DEFAULT_SPAN_MS)
+    , m_dragX(0)
+    , m_dragEndMs(0)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setToolTip(tr("wheel: zoom, drag: pan, double click: live view"));
+    connect(m_frameTimer, &QTimer::timeout, this, &TrendPlot::onFrame);
+    m_frameTimer->start(FRAME_MS);
+}
+
+QSize TrendPlot::sizeHint() const
+{
+    return QSize(400, 180);
+}
+
+void TrendPlot::addSample(const SAMPLE &x)
+{
+    m_history.append(x);
+    m_dirty = true;
+}
+
+void TrendPlot::clear()
+{
+    m_history.clear();
+    m_follow = true;
+    update();
+}
+
+void TrendPlot::onFrame()
+{
+    if (m_dirty && isVisible()) {
+        m_dirty = false;
+        update();
+    }
+}
+
+qint64 TrendPlot::viewEnd() const
+{
+    if (!m_follow)
+        return m_endMs;
+    return m_history.isEmpty() ? QDateTime::currentMSecsSinceEpoch() : m_history.timeAt(m_history.end() - 1);
+}
+
+void TrendPlot::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    QPainter p(this);
+    p.fillRect(rect(), Qt::black);
+    int w = width() - LABEL_WIDTH;
+    if ((w <= 1) || (height() < 3*TrendHistory::CHANNELS))
+        return;
+    qint64 end = viewEnd();
+    qint64 start = end - m_spanMs;
+    double msPerPixel = double(m_spanMs) / w;
+
+    // sample ranges of all columns, shared by the strips
+    m_columnSeq.resize(w + 1);
+    for (int x=0; x<=w; ++x)
+        m_columnSeq[x] = m_history.seqAt(start + qint64(std::ceil(x * msPerPixel)));
+
+    int h = height() / TrendHistory::CHANNELS;
+    for (int c=0; c<TrendHistory::CHANNELS; ++c)
+        drawStrip(p, QRect(0, c*h, width(), h), c);
+
+    p.setPen(Qt::gray);
+    QString span = (m_spanMs >= 120000) ? tr("%1 min").arg(m_spanMs / 60000.0, 0, 'f', 1)
+                                        : tr("%1 s").arg(m_spanMs / 1000.0, 0, 'f', 1);
+    p.drawText(QRect(0, 0, w, height()), Qt::AlignBottom | Qt::AlignHCenter,
+               m_follow ? span : span + tr(" until %1").arg(QDateTime::fromMSecsSinceEpoch(end).toString("hh:mm:ss")));
+}
+
+void TrendPlot::drawStrip(QPainter &p, const QRect &r, int channel)
+{
+    int w = r.width() - LABEL_WIDTH;
+    p.setPen(QColor(40, 40, 40));
+    p.drawLine(r.left(), r.bottom(), r.right(), r.bottom());
+
+    // extremes per column, NaN for columns without samples
+    m_lo.resize(w);
+    m_hi.resize(w);
+    float lo = 0, hi = 0;
+    bool any = false;
+    for (int x=0; x<w; ++x) {
+        float l, h;
+        if (m_history.minMax(channel, m_columnSeq.at(x), m_columnSeq.at(x+1), l, h)) {
+            m_lo[x] = l;
+            m_hi[x] = h;
+            lo = any ? qMin(lo, l) : l;
+            hi = any ? qMax(hi, h) : h;
+            any = true;
+        } else {
+            m_lo[x] = m_hi[x] = NAN;
+        }
+    }
+    p.setPen(channels[channel].color);
+    p.drawText(r.adjusted(4, 2, 0, 0), Qt::AlignLeft | Qt::AlignTop, channels[channel].name);
+    if (!any)
+        return;
+
+    // autoscale with some headroom, a flat line sits in the middle
+    float range = hi - lo;
+    if (range < 0.01f)
+        range = 0.01f;
+    float margin = range * 0.05f;
+    float bottom = lo - margin;
+    float scale = (r.height() - 4) / (range + 2*margin);
+    auto y = [&](float v) { return r.bottom() - 2 - (v - bottom) * scale; };
+
+    m_lines.resize(0);
+    int last = -1;
+    for (int x=0; x<w; ++x) {
+        if (std::isnan(m_lo.at(x)))
+            continue;
+        if (last >= 0) {
+            // connect the last sample of the previous column with the first of this one
+            float from = m_history.valueAt(channel, m_columnSeq.at(last+1) - 1);
+            float to = m_history.valueAt(channel, m_columnSeq.at(x));
+            m_lines.append(QLineF(last, y(from), x, y(to)));
+        }
+        // a spike shows up even if it is a single sample among thousands
+        m_lines.append(QLineF(x, y(m_lo.at(x)), x, y(m_hi.at(x))));
+        last = x;
+    }
+    p.drawLines(m_lines);
+
+    QRect labels(r.right() - LABEL_WIDTH + 4, r.top() + 2, LABEL_WIDTH - 6, r.height() - 4);
+    p.drawText(labels, Qt::AlignRight | Qt::AlignTop, QString("%1 %2").arg(hi, 0, 'f', 2).arg(channels[channel].unit));
+    p.drawText(labels, Qt::AlignRight | Qt::AlignBottom, QString("%1 %2").arg(lo, 0, 'f', 2).arg(channels[channel].unit));
+}
+
+void TrendPlot::wheelEvent(QWheelEvent *event)
+{
+    double steps = event->angleDelta().y() / 120.0;
+    if (steps == 0)
+        return;
+    qint64 span = qBound(qint64(MIN_SPAN_MS), qint64(m_spanMs * std::pow(ZOOM_STEP, -steps)), qint64(MAX_SPAN_MS));
+    if (!m_follow) {
+        // keep the time under the mouse in place
+        int w = qMax(1, width() - LABEL_WIDTH);
+        double f = qBound(0.0, event->position().x() / w, 1.0);
+        qint64 t = m_endMs - m_spanMs + qint64(f * m_spanMs);
+        m_endMs = t + qint64((1.0 - f) * span);
+    }
+    m_spanMs = span;
+    update();
+    event->accept();
+}
+
+void TrendPlot::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragX = event->x();
+        m_dragEndMs = viewEnd();
+    }
+}
+
+void TrendPlot::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton) || m_history.isEmpty())
+        return;
+    int w = qMax(1, width() - LABEL_WIDTH);
+    qint64 end = m_dragEndMs - qint64(double(event->x() - m_dragX) * m_spanMs / w);
+    qint64 newest = m_history.timeAt(m_history.end() - 1);
+    m_follow = (end >= newest);
+    m_endMs = qMin(end, newest);
+    update();
+}
+
+void TrendPlot::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event)
+    m_follow = true;
+    update();
+}
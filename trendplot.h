@@ -0,0 +1,67 @@
+// ***************************************************************************
+// DP700 power supply serial control tool
+// ---------------------------------------------------------------------------
+// trendplot.h
+// live trend plot of voltage, current and power, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef TRENDPLOT_H
+#define TRENDPLOT_H
+
+#include <QWidget>
+#include <QVector>
+#include <QLineF>
+#include "trendhistory.h"
+
+class QTimer;
+
+// one strip per channel, every pixel column shows min and max of the samples
+// it covers, so the drawing cost depends on the width only
+// mouse wheel: zoom, drag: pan, double click: back to the live view
+class TrendPlot : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit TrendPlot(QWidget *parent = nullptr);
+
+    QSize sizeHint() const override;
+
+public slots:
+    void addSample(const SAMPLE &x);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private slots:
+    void onFrame();
+
+private:
+    void drawStrip(QPainter &p, const QRect &r, int channel);
+    qint64 viewEnd() const;
+
+    TrendHistory    m_history;
+    QTimer          *m_frameTimer;
+    bool            m_dirty;
+    bool            m_follow;           // the view ends at the newest sample
+    qint64          m_endMs;            // end of the view if not following
+    qint64          m_spanMs;
+    int             m_dragX;
+    qint64          m_dragEndMs;
+    // per column extremes and line buffer, reused for every frame
+    QVector<quint64> m_columnSeq;
+    QVector<float>  m_lo;
+    QVector<float>  m_hi;
+    QVector<QLineF> m_lines;
+};
+
+#endif // TRENDPLOT_H